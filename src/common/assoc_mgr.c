@@ -38,6 +38,7 @@
 
 #include "assoc_mgr.h"
 
+#include <sys/time.h>
 #include <sys/types.h>
 #include <pwd.h>
 #include <fcntl.h>
@@ -77,6 +78,18 @@ static slurmdb_assoc_rec_t **assoc_hash = NULL;
 static pthread_mutex_t locks_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t locks_cond = PTHREAD_COND_INITIALIZER;
 
+/*
+ * Contention statistics for each data type, protected by locks_mutex. They
+ * only measure how long readers wait behind writers (say a long sacctmgr
+ * update holding the assoc write lock), they do not change the locking.
+ */
+static assoc_mgr_lock_stats_t lock_stats[ASSOC_MGR_ENTITY_COUNT];
+static struct timeval lock_write_start[ASSOC_MGR_ENTITY_COUNT];
+
+static const char *lock_stats_names[ASSOC_MGR_ENTITY_COUNT] = {
+	"assoc", "file", "qos", "res", "tres", "user", "wckey"
+};
+
 static int _get_str_inx(char *name)
 {
 	int j, index = 0;
@@ -1847,9 +1860,21 @@ static int _refresh_assoc_wckey_list(void *db_conn, int enforce)
 	return SLURM_SUCCESS;
 }
 
+static uint64_t _usec_since(struct timeval *start)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return ((now.tv_sec - start->tv_sec) * 1000000) +
+		(now.tv_usec - start->tv_usec);
+}
+
 /* _wr_rdlock - Issue a read lock on the specified data type */
 static void _wr_rdlock(assoc_mgr_lock_datatype_t datatype)
 {
+	struct timeval wait_start;
+	bool waited = false;
+
 	//info("going to read lock on %d", datatype);
 	slurm_mutex_lock(&locks_mutex);
 	//info("read lock on %d", datatype);
@@ -1861,9 +1886,16 @@ static void _wr_rdlock(assoc_mgr_lock_datatype_t datatype)
 			assoc_mgr_locks.entity[read_lock(datatype)]++;
 			break;
 		} else {	/* wait for state change and retry */
+			if (!waited) {
+				gettimeofday(&wait_start, NULL);
+				waited = true;
+			}
 			slurm_cond_wait(&locks_cond, &locks_mutex);
 		}
 	}
+	lock_stats[datatype].read_cnt++;
+	if (waited)
+		lock_stats[datatype].read_wait_usec += _usec_since(&wait_start);
 	slurm_mutex_unlock(&locks_mutex);
 }
 
@@ -1881,6 +1913,9 @@ static void _wr_rdunlock(assoc_mgr_lock_datatype_t datatype)
 /* _wr_wrlock - Issue a write lock on the specified data type */
 static void _wr_wrlock(assoc_mgr_lock_datatype_t datatype)
 {
+	struct timeval wait_start;
+	bool waited = false;
+
 	//info("going to write lock on %d", datatype);
 	slurm_mutex_lock(&locks_mutex);
 	assoc_mgr_locks.entity[write_wait_lock(datatype)]++;
@@ -1894,18 +1929,33 @@ static void _wr_wrlock(assoc_mgr_lock_datatype_t datatype)
 				entity[write_wait_lock(datatype)]--;
 			break;
 		} else {	/* wait for state change and retry */
+			if (!waited) {
+				gettimeofday(&wait_start, NULL);
+				waited = true;
+			}
 			slurm_cond_wait(&locks_cond, &locks_mutex);
 		}
 	}
+	lock_stats[datatype].write_cnt++;
+	gettimeofday(&lock_write_start[datatype], NULL);
+	if (waited)
+		lock_stats[datatype].write_wait_usec += _usec_since(&wait_start);
 	slurm_mutex_unlock(&locks_mutex);
 }
 
 /* _wr_wrunlock - Issue a write unlock on the specified data type */
 static void _wr_wrunlock(assoc_mgr_lock_datatype_t datatype)
 {
+	uint64_t hold_usec;
+
 	//info("going to write unlock on %d", datatype);
 	slurm_mutex_lock(&locks_mutex);
 	//info("write unlock on %d", datatype);
+	hold_usec = _usec_since(&lock_write_start[datatype]);
+	lock_stats[datatype].write_hold_usec += hold_usec;
+	if (hold_usec > lock_stats[datatype].write_hold_max_usec)
+		lock_stats[datatype].write_hold_max_usec = hold_usec;
+	lock_stats[datatype].version++;
 	assoc_mgr_locks.entity[write_lock(datatype)]--;
 	slurm_cond_broadcast(&locks_cond);
 	slurm_mutex_unlock(&locks_mutex);
@@ -2118,6 +2168,53 @@ extern void assoc_mgr_unlock(assoc_mgr_lock_t *locks)
 		_wr_wrunlock(ASSOC_LOCK);
 }
 
+extern uint32_t assoc_mgr_lock_version(assoc_mgr_lock_datatype_t datatype)
+{
+	uint32_t version;
+
+	xassert(datatype < ASSOC_MGR_ENTITY_COUNT);
+
+	slurm_mutex_lock(&locks_mutex);
+	version = lock_stats[datatype].version;
+	slurm_mutex_unlock(&locks_mutex);
+
+	return version;
+}
+
+extern void assoc_mgr_get_lock_stats(assoc_mgr_lock_stats_t *stats,
+				     bool reset)
+{
+	int i;
+
+	slurm_mutex_lock(&locks_mutex);
+	memcpy(stats, lock_stats, sizeof(lock_stats));
+	if (reset) {
+		memset(lock_stats, 0, sizeof(lock_stats));
+		for (i = 0; i < ASSOC_MGR_ENTITY_COUNT; i++)
+			lock_stats[i].version = stats[i].version;
+	}
+	slurm_mutex_unlock(&locks_mutex);
+}
+
+extern void assoc_mgr_log_lock_stats(bool reset)
+{
+	assoc_mgr_lock_stats_t stats[ASSOC_MGR_ENTITY_COUNT];
+	int i;
+
+	assoc_mgr_get_lock_stats(stats, reset);
+	for (i = 0; i < ASSOC_MGR_ENTITY_COUNT; i++) {
+		if (!stats[i].read_cnt && !stats[i].write_cnt)
+			continue;
+		info("assoc_mgr %s lock: read %"PRIu64" (wait %"PRIu64" usec) "
+		     "write %"PRIu64" (wait %"PRIu64" usec, "
+		     "held %"PRIu64" usec, max %"PRIu64" usec)",
+		     lock_stats_names[i],
+		     stats[i].read_cnt, stats[i].read_wait_usec,
+		     stats[i].write_cnt, stats[i].write_wait_usec,
+		     stats[i].write_hold_usec, stats[i].write_hold_max_usec);
+	}
+}
+
 /* Since the returned assoc_list is full of pointers from the
  * assoc_mgr_assoc_list assoc_mgr_lock_t READ_LOCK on
  * assocs must be set before calling this function and while
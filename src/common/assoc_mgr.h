@@ -93,6 +93,17 @@ typedef struct {
 	int entity[ASSOC_MGR_ENTITY_COUNT * 4];
 } assoc_mgr_lock_flags_t;
 
+/* Contention statistics kept for each assoc_mgr_lock_datatype_t */
+typedef struct {
+	uint64_t read_cnt;		/* read locks granted */
+	uint64_t read_wait_usec;	/* time spent waiting for read locks */
+	uint64_t write_cnt;		/* write locks granted */
+	uint64_t write_wait_usec;	/* time spent waiting for write locks */
+	uint64_t write_hold_usec;	/* time write locks were held */
+	uint64_t write_hold_max_usec;	/* longest a write lock was held */
+	uint32_t version;		/* bumped on every write unlock */
+} assoc_mgr_lock_stats_t;
+
 typedef struct {
  	uint16_t cache_level;
 	uint16_t enforce;
@@ -130,9 +141,32 @@ extern uint32_t g_tres_count; /* Number of TRES from the database
 extern int assoc_mgr_init(void *db_conn, assoc_init_args_t *args,
 			  int db_conn_errno);
 extern int assoc_mgr_fini(char *state_save_location);
+/*
+ * Read/write lock the data types set in locks. A read lock waits while a
+ * write lock on the same data type is held or waiting. The time spent
+ * waiting is counted per data type, see assoc_mgr_get_lock_stats().
+ */
 extern void assoc_mgr_lock(assoc_mgr_lock_t *locks);
 extern void assoc_mgr_unlock(assoc_mgr_lock_t *locks);
 
+/*
+ * Return the number of times a write lock on the given data type has been
+ * released. A caller may keep something derived from the data under a read
+ * lock and reuse it for as long as the version is unchanged.
+ */
+extern uint32_t assoc_mgr_lock_version(assoc_mgr_lock_datatype_t datatype);
+
+/*
+ * Copy out the lock statistics of every data type.
+ * OUT stats - array of ASSOC_MGR_ENTITY_COUNT records
+ * IN reset - clear the counters (but not the versions) after copying
+ */
+extern void assoc_mgr_get_lock_stats(assoc_mgr_lock_stats_t *stats,
+				     bool reset);
+
+/* Log the lock statistics of every data type, optionally clearing them */
+extern void assoc_mgr_log_lock_stats(bool reset);
+
 /*
  * get info from the storage
  * IN:  assoc - slurmdb_assoc_rec_t with at least cluster and
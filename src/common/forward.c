@@ -65,12 +65,24 @@ typedef struct {
 	int timeout;
 	hostlist_t tree_hl;
 	pthread_mutex_t *tree_mutex;
+	bool resend;		/* nodes may have seen orig_msg already */
 } fwd_tree_t;
 
+/*
+ * Nodes known to index the node table the same way we do, as node table
+ * indexes. Only slurmctld records any, from the slurm.conf hash each node
+ * registers with, see forward_set_node_table_ok(). A forward list is sent
+ * as node indexes only to these nodes, everyone else gets the names.
+ */
+static pthread_mutex_t table_ok_lock = PTHREAD_MUTEX_INITIALIZER;
+static bitstr_t *table_ok_nodes = NULL;
+static uint32_t table_ok_conf_hash = 0;	/* slurm.conf hash of the above */
+
 static void _start_msg_tree_internal(hostlist_t hl, hostlist_t* sp_hl,
 				     fwd_tree_t *fwd_tree_in,
 				     int hl_count);
 static void _forward_msg_internal(hostlist_t hl, hostlist_t* sp_hl,
+				  bitstr_t **sp_nodes,
 				  forward_struct_t *fwd_struct,
 				  header_t *header, int timeout,
 				  int hl_count);
@@ -94,6 +106,85 @@ void _destroy_tree_fwd(fwd_tree_t *fwd_tree)
 	}
 }
 
+/*
+ * Return true if a forward list may be sent to node_name as node indexes,
+ * that is node_name has registered with the same slurm.conf as ours
+ */
+static bool _node_table_ok(const char *node_name)
+{
+	uint32_t conf_hash;
+	int index, node_cnt;
+	bool ok = false;
+
+	if (working_cluster_rec)
+		return false;	/* Our node table is not the cluster's */
+
+	slurm_mutex_lock(&table_ok_lock);
+	if (!table_ok_nodes) {
+		slurm_mutex_unlock(&table_ok_lock);
+		return false;
+	}
+	slurm_mutex_unlock(&table_ok_lock);
+
+	conf_hash = slurm_get_hash_val();
+	node_cnt = slurm_conf_get_node_table(NULL);
+	if ((index = slurm_conf_get_node_index(node_name)) < 0)
+		return false;
+
+	slurm_mutex_lock(&table_ok_lock);
+	if (table_ok_nodes && (table_ok_conf_hash == conf_hash) &&
+	    (bit_size(table_ok_nodes) == node_cnt) && (index < node_cnt))
+		ok = bit_test(table_ok_nodes, index);
+	slurm_mutex_unlock(&table_ok_lock);
+
+	return ok;
+}
+
+/* Return the next node to send to, removing it from the forward list */
+static char *_fwd_shift(forward_msg_t *fwd_msg, hostlist_t hl)
+{
+	bitstr_t *nodes = fwd_msg->header.forward.nodes;
+	char *node_name, *name = NULL;
+	int index;
+
+	if (!nodes)
+		return hostlist_shift(hl);
+
+	if ((index = bit_ffs(nodes)) < 0)
+		return NULL;
+	bit_clear(nodes, index);
+	/* Match hostlist_shift(), the caller free()s the name */
+	if ((node_name = slurm_conf_get_node_by_index(index))) {
+		name = strdup(node_name);
+		xfree(node_name);
+	}
+	return name;
+}
+
+static int _fwd_count(forward_msg_t *fwd_msg, hostlist_t hl)
+{
+	if (fwd_msg->header.forward.nodes)
+		return bit_set_count(fwd_msg->header.forward.nodes);
+	return hostlist_count(hl);
+}
+
+/*
+ * Move any nodes still held as indexes into hl. The error paths work on
+ * names only, so this is done before taking any of them.
+ */
+static void _fwd_to_hostlist(forward_msg_t *fwd_msg, hostlist_t hl)
+{
+	hostlist_t nodes_hl;
+
+	if (!fwd_msg->header.forward.nodes)
+		return;
+
+	nodes_hl = forward_bitmap2hostlist(fwd_msg->header.forward.nodes);
+	hostlist_push_list(hl, nodes_hl);
+	hostlist_destroy(nodes_hl);
+	FREE_NULL_BITMAP(fwd_msg->header.forward.nodes);
+}
+
 void *_forward_thread(void *arg)
 {
 	forward_msg_t *fwd_msg = (forward_msg_t *)arg;
@@ -110,7 +201,7 @@ void *_forward_thread(void *arg)
 	int start_timeout = fwd_msg->timeout;
 
 	/* repeat until we are sure the message was sent */
-	while ((name = hostlist_shift(hl))) {
+	while ((name = _fwd_shift(fwd_msg, hl))) {
 		if (slurm_conf_get_addr(name, &addr) == SLURM_ERROR) {
 			error("forward_thread: can't find address for host "
 			      "%s, check slurm.conf", name);
@@ -118,7 +209,7 @@ void *_forward_thread(void *arg)
 			mark_as_failed_forward(&fwd_struct->ret_list, name,
 					       SLURM_UNKNOWN_FORWARD_ADDR);
  			free(name);
-			if (hostlist_count(hl) > 0) {
+			if (_fwd_count(fwd_msg, hl) > 0) {
 				slurm_mutex_unlock(&fwd_struct->forward_mutex);
 				continue;
 			}
@@ -132,31 +223,44 @@ void *_forward_thread(void *arg)
 				&fwd_struct->ret_list, name,
 				SLURM_COMMUNICATIONS_CONNECTION_ERROR);
 			free(name);
-			if (hostlist_count(hl) > 0) {
+			if (_fwd_count(fwd_msg, hl) > 0) {
 				slurm_mutex_unlock(&fwd_struct->forward_mutex);
 				/* Abandon tree. This way if all the
 				 * nodes in the branch are down we
 				 * don't have to time out for each
 				 * node serially.
 				 */
-				_forward_msg_internal(hl, NULL, fwd_struct,
+				_fwd_to_hostlist(fwd_msg, hl);
+				_forward_msg_internal(hl, NULL, NULL,
+						      fwd_struct,
 						      &fwd_msg->header, 0,
 						      hostlist_count(hl));
 				continue;
 			}
 			goto cleanup;
 		}
-		buf = hostlist_ranged_string_xmalloc(hl);
+		if (fwd_msg->header.forward.nodes && !_node_table_ok(name))
+			_fwd_to_hostlist(fwd_msg, hl);
+		if (fwd_msg->header.forward.nodes) {
+			/* The rest of the list goes on as indexes too */
+			fwd_msg->header.forward.cnt =
+				bit_set_count(fwd_msg->header.forward.nodes);
+		} else {
+			buf = hostlist_ranged_string_xmalloc(hl);
 
-		xfree(fwd_msg->header.forward.nodelist);
-		fwd_msg->header.forward.nodelist = buf;
-		fwd_msg->header.forward.cnt = hostlist_count(hl);
+			xfree(fwd_msg->header.forward.nodelist);
+			fwd_msg->header.forward.nodelist = buf;
+			fwd_msg->header.forward.cnt = hostlist_count(hl);
+		}
 #if 0
 		info("sending %d forwards (%s) to %s",
 		     fwd_msg->header.forward.cnt,
 		     fwd_msg->header.forward.nodelist, name);
 #endif
-		if (fwd_msg->header.forward.nodelist[0]) {
+		if (fwd_msg->header.forward.nodes) {
+			debug3("forward: send to %s along with %u indexed nodes",
+			       name, fwd_msg->header.forward.cnt);
+		} else if (fwd_msg->header.forward.nodelist[0]) {
 			debug3("forward: send to %s along with %s",
 			       name, fwd_msg->header.forward.nodelist);
 		} else
@@ -190,7 +294,7 @@ void *_forward_thread(void *arg)
 			mark_as_failed_forward(&fwd_struct->ret_list, name,
 					       errno);
 			free(name);
-			if (hostlist_count(hl) > 0) {
+			if (_fwd_count(fwd_msg, hl) > 0) {
 				free_buf(buffer);
 				buffer = init_buf(fwd_struct->buf_len);
 				slurm_mutex_unlock(&fwd_struct->forward_mutex);
@@ -201,7 +305,9 @@ void *_forward_thread(void *arg)
 				 * don't have to time out for each
 				 * node serially.
 				 */
-				_forward_msg_internal(hl, NULL, fwd_struct,
+				_fwd_to_hostlist(fwd_msg, hl);
+				_forward_msg_internal(hl, NULL, NULL,
+						      fwd_struct,
 						      &fwd_msg->header, 0,
 						      hostlist_count(hl));
 				continue;
@@ -216,6 +322,7 @@ void *_forward_thread(void *arg)
 		if ((fwd_msg->header.msg_type == REQUEST_SHUTDOWN) ||
 		    (fwd_msg->header.msg_type == REQUEST_RECONFIGURE) ||
 		    (fwd_msg->header.msg_type == REQUEST_REBOOT_NODES)) {
+			_fwd_to_hostlist(fwd_msg, hl);
 			slurm_mutex_lock(&fwd_struct->forward_mutex);
 			ret_data_info = xmalloc(sizeof(ret_data_info_t));
 			list_push(fwd_struct->ret_list, ret_data_info);
@@ -261,7 +368,7 @@ void *_forward_thread(void *arg)
 					       errno);
 			free(name);
 			FREE_NULL_LIST(ret_list);
-			if (hostlist_count(hl) > 0) {
+			if (_fwd_count(fwd_msg, hl) > 0) {
 				free_buf(buffer);
 				buffer = init_buf(fwd_struct->buf_len);
 				slurm_mutex_unlock(&fwd_struct->forward_mutex);
@@ -280,8 +387,10 @@ void *_forward_thread(void *arg)
 			ListIterator itr = NULL;
 			char *tmp = NULL;
 			int first_node_found = 0;
-			hostlist_iterator_t host_itr
-				= hostlist_iterator_create(hl);
+			hostlist_iterator_t host_itr;
+
+			_fwd_to_hostlist(fwd_msg, hl);
+			host_itr = hostlist_iterator_create(hl);
 			error("We shouldn't be here.  We forwarded to %d "
 			      "but only got %d back",
 			      (fwd_msg->header.forward.cnt+1),
@@ -358,6 +467,13 @@ void *_fwd_tree_thread(void *arg)
 	send_msg.msg_type = fwd_tree->orig_msg->msg_type;
 	send_msg.data = fwd_tree->orig_msg->data;
 	send_msg.protocol_version = fwd_tree->orig_msg->protocol_version;
+	/*
+	 * Nodes below a branch which failed part way may already have
+	 * decoded the shared credential, which would then be rejected as
+	 * replayed, so only the first send of the fan-out uses it
+	 */
+	if (!fwd_tree->resend)
+		send_msg.envelope = fwd_tree->orig_msg->envelope;
 
 	/* repeat until we are sure the message was sent */
 	while ((name = hostlist_shift(fwd_tree->tree_hl))) {
@@ -376,14 +492,33 @@ void *_fwd_tree_thread(void *arg)
 		}
 
 		send_msg.forward.timeout = fwd_tree->timeout;
+		send_msg.forward.nodelist = NULL;
+		send_msg.forward.nodes = NULL;
 		if ((send_msg.forward.cnt = hostlist_count(fwd_tree->tree_hl))){
-			buf = hostlist_ranged_string_xmalloc(
-					fwd_tree->tree_hl);
-			send_msg.forward.nodelist = buf;
-		} else
-			send_msg.forward.nodelist = NULL;
+			/*
+			 * Send node indexes where possible so that no hop
+			 * below us has to parse or render a node list
+			 */
+			if (_node_table_ok(name)) {
+				send_msg.forward.nodes =
+					forward_hostlist2bitmap(
+						fwd_tree->tree_hl);
+			}
+			if (send_msg.forward.nodes) {
+				send_msg.forward.cnt =
+					bit_set_count(send_msg.forward.nodes);
+			} else {
+				buf = hostlist_ranged_string_xmalloc(
+						fwd_tree->tree_hl);
+				send_msg.forward.nodelist = buf;
+			}
+		}
 
-		if (send_msg.forward.nodelist && send_msg.forward.nodelist[0]) {
+		if (send_msg.forward.nodes) {
+			debug3("Tree sending to %s along with %u indexed nodes",
+			       name, send_msg.forward.cnt);
+		} else if (send_msg.forward.nodelist &&
+			   send_msg.forward.nodelist[0]) {
 			debug3("Tree sending to %s along with %s",
 			       name, send_msg.forward.nodelist);
 		} else
@@ -391,8 +526,10 @@ void *_fwd_tree_thread(void *arg)
 
 		ret_list = slurm_send_addr_recv_msgs(&send_msg, name,
 						     fwd_tree->timeout);
+		send_msg.envelope = NULL;
 
 		xfree(send_msg.forward.nodelist);
+		FREE_NULL_BITMAP(send_msg.forward.nodes);
 
 		if (ret_list) {
 			int ret_cnt = list_count(ret_list);
@@ -437,6 +574,7 @@ void *_fwd_tree_thread(void *arg)
 				 * don't have to time out for each
 				 * node serially.
 				 */
+				fwd_tree->resend = true;
 				_start_msg_tree_internal(
 					fwd_tree->tree_hl, NULL,
 					fwd_tree,
@@ -542,6 +680,7 @@ static void _start_msg_tree_internal(hostlist_t hl, hostlist_t* sp_hl,
 }
 
 static void _forward_msg_internal(hostlist_t hl, hostlist_t* sp_hl,
+				  bitstr_t **sp_nodes,
 				  forward_struct_t *fwd_struct,
 				  header_t *header, int timeout,
 				  int hl_count)
@@ -576,22 +715,31 @@ static void _forward_msg_internal(hostlist_t hl, hostlist_t* sp_hl,
 
 		fwd_msg->header.version = header->version;
 		fwd_msg->header.flags = header->flags;
+		/*
+		 * Replies from the next hop come back through us and are
+		 * small, do not let them be compressed.
+		 */
+		fwd_msg->header.flags &= ~SLURM_MSG_ACCEPT_LZ4;
 		fwd_msg->header.msg_type = header->msg_type;
 		fwd_msg->header.body_length = header->body_length;
 		fwd_msg->header.ret_list = NULL;
 		fwd_msg->header.ret_cnt = 0;
 
-		if (sp_hl) {
-			buf = hostlist_ranged_string_xmalloc(sp_hl[j]);
-			hostlist_destroy(sp_hl[j]);
+		forward_init(&fwd_msg->header.forward, NULL);
+		if (sp_nodes) {
+			fwd_msg->header.forward.nodes = sp_nodes[j];
+			sp_nodes[j] = NULL;
 		} else {
-			tmp_char = hostlist_shift(hl);
-			buf = xstrdup(tmp_char);
-			free(tmp_char);
+			if (sp_hl) {
+				buf = hostlist_ranged_string_xmalloc(sp_hl[j]);
+				hostlist_destroy(sp_hl[j]);
+			} else {
+				tmp_char = hostlist_shift(hl);
+				buf = xstrdup(tmp_char);
+				free(tmp_char);
+			}
+			fwd_msg->header.forward.nodelist = buf;
 		}
-
-		forward_init(&fwd_msg->header.forward, NULL);
-		fwd_msg->header.forward.nodelist = buf;
 		while (pthread_create(&thread_agent, &attr_agent,
 				     _forward_thread,
 				     (void *)fwd_msg)) {
@@ -604,6 +752,152 @@ static void _forward_msg_internal(hostlist_t hl, hostlist_t* sp_hl,
 	}
 }
 
+/*
+ * The default route plugin splits a list into consecutive runs of nodes, which
+ * for a node index bitmap can be done without ever building a hostlist.
+ * Other route plugins need the names, see route_g_split_hostlist().
+ */
+static bool _route_split_by_index(void)
+{
+	static int by_index = -1;
+	char *route_type;
+
+	if (by_index == -1) {
+		route_type = slurm_get_route_plugin();
+		by_index = !xstrcmp(route_type, "route/default");
+		xfree(route_type);
+	}
+
+	return by_index;
+}
+
+/*
+ * Split a node index bitmap the same way route_split_hostlist_treewidth()
+ * splits a hostlist: each child gets one node plus its span of the rest.
+ * RET xmalloc()ed array of *count bitmaps
+ */
+static bitstr_t **_split_nodes(bitstr_t *nodes, uint16_t tree_width,
+			       int *count)
+{
+	bitstr_t **sp_nodes;
+	int *span;
+	int i, first, last, left = 0, nbm = -1;
+
+	if (!tree_width)
+		tree_width = slurm_get_tree_width();
+
+	span = set_span(bit_set_count(nodes), tree_width);
+	sp_nodes = xmalloc(sizeof(bitstr_t *) * tree_width);
+
+	first = bit_ffs(nodes);
+	last = bit_fls(nodes);
+	for (i = first; (first >= 0) && (i <= last); i++) {
+		if (!bit_test(nodes, i))
+			continue;
+		if (left == 0) {
+			nbm++;
+			sp_nodes[nbm] = bit_alloc(bit_size(nodes));
+			left = span[nbm] + 1;
+		}
+		bit_set(sp_nodes[nbm], i);
+		left--;
+	}
+	xfree(span);
+	*count = nbm + 1;
+
+	return sp_nodes;
+}
+
+/*
+ * forward_hostlist2bitmap - build a bitmap of node table indexes
+ * IN: hl - hostlist_t - nodes to convert, left unchanged
+ * RET bitstr_t * - bitmap or NULL if any node is not in the node table,
+ *		    in which case the names must be sent instead
+ */
+extern bitstr_t *forward_hostlist2bitmap(hostlist_t hl)
+{
+	hostlist_iterator_t itr;
+	bitstr_t *nodes;
+	char *name;
+	int node_cnt, index;
+
+	if (!(node_cnt = slurm_conf_get_node_table(NULL)))
+		return NULL;
+
+	nodes = bit_alloc(node_cnt);
+	itr = hostlist_iterator_create(hl);
+	while ((name = hostlist_next(itr))) {
+		index = slurm_conf_get_node_index(name);
+		free(name);
+		if (index < 0) {
+			FREE_NULL_BITMAP(nodes);
+			break;
+		}
+		bit_set(nodes, index);
+	}
+	hostlist_iterator_destroy(itr);
+
+	return nodes;
+}
+
+/*
+ * forward_set_node_table_ok - record whether a node registered with the
+ *	same slurm.conf as ours, and so may be sent node index forward lists
+ */
+extern void forward_set_node_table_ok(const char *node_name, bool ok)
+{
+	uint32_t conf_hash;
+	int index, node_cnt;
+
+	if ((index = slurm_conf_get_node_index(node_name)) < 0)
+		return;
+	node_cnt = slurm_conf_get_node_table(NULL);
+	conf_hash = slurm_get_hash_val();
+
+	slurm_mutex_lock(&table_ok_lock);
+	if (table_ok_nodes && ((table_ok_conf_hash != conf_hash) ||
+			       (bit_size(table_ok_nodes) != node_cnt))) {
+		/* Reconfigured, every node must register again */
+		FREE_NULL_BITMAP(table_ok_nodes);
+	}
+	if (!table_ok_nodes) {
+		table_ok_nodes = bit_alloc(node_cnt);
+		table_ok_conf_hash = conf_hash;
+	}
+	if (index < node_cnt) {
+		if (ok)
+			bit_set(table_ok_nodes, index);
+		else
+			bit_clear(table_ok_nodes, index);
+	}
+	slurm_mutex_unlock(&table_ok_lock);
+}
+
+/*
+ * forward_bitmap2hostlist - build a hostlist from node table indexes
+ * IN: nodes - bitstr_t * - nodes to convert
+ * RET hostlist_t - caller must hostlist_destroy() it
+ */
+extern hostlist_t forward_bitmap2hostlist(bitstr_t *nodes)
+{
+	hostlist_t hl = hostlist_create(NULL);
+	char *name;
+	int i, first, last;
+
+	first = bit_ffs(nodes);
+	last = bit_fls(nodes);
+	for (i = first; (first >= 0) && (i <= last); i++) {
+		if (!bit_test(nodes, i))
+			continue;
+		if ((name = slurm_conf_get_node_by_index(i))) {
+			hostlist_push_host(hl, name);
+			xfree(name);
+		}
+	}
+
+	return hl;
+}
+
 /*
  * forward_init    - initilize forward structure
  * IN: forward     - forward_t *   - struct to store forward info
@@ -643,8 +937,25 @@ extern int forward_msg(forward_struct_t *forward_struct, header_t *header)
 		error("didn't get a ret_list from forward_struct");
 		return SLURM_ERROR;
 	}
-	hl = hostlist_create(header->forward.nodelist);
-	hostlist_uniq(hl);
+
+	if (header->forward.nodes && _route_split_by_index()) {
+		bitstr_t **sp_nodes;
+
+		sp_nodes = _split_nodes(header->forward.nodes,
+					header->forward.tree_width, &hl_count);
+		_forward_msg_internal(NULL, NULL, sp_nodes, forward_struct,
+				      header, forward_struct->timeout,
+				      hl_count);
+		xfree(sp_nodes);
+		return SLURM_SUCCESS;
+	}
+
+	if (header->forward.nodes) {
+		hl = forward_bitmap2hostlist(header->forward.nodes);
+	} else {
+		hl = hostlist_create(header->forward.nodelist);
+		hostlist_uniq(hl);
+	}
 
 	if (route_g_split_hostlist(
 		    hl, &sp_hl, &hl_count, header->forward.tree_width)) {
@@ -653,7 +964,7 @@ extern int forward_msg(forward_struct_t *forward_struct, header_t *header)
 		return SLURM_ERROR;
 	}
 
-	_forward_msg_internal(NULL, sp_hl, forward_struct, header,
+	_forward_msg_internal(NULL, sp_hl, NULL, forward_struct, header,
 			      forward_struct->timeout, hl_count);
 
 	xfree(sp_hl);
@@ -802,6 +1113,7 @@ void destroy_forward(forward_t *forward)
 {
 	if (forward->init == FORWARD_INIT) {
 		xfree(forward->nodelist);
+		FREE_NULL_BITMAP(forward->nodes);
 		forward->init = 0;
 	} else {
 		error("destroy_forward: no init");
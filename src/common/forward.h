@@ -51,6 +51,30 @@
  */
 extern void forward_init(forward_t *forward, forward_t *from);
 
+/*
+ * forward_hostlist2bitmap - build a bitmap of node table indexes
+ * IN: hl - hostlist_t - nodes to convert, left unchanged
+ * RET bitstr_t * - bitmap or NULL if any node is not in the node table,
+ *		    in which case the names must be sent instead
+ */
+extern bitstr_t *forward_hostlist2bitmap(hostlist_t hl);
+
+/*
+ * forward_set_node_table_ok - record whether a node registered with the
+ *	same slurm.conf as ours, and so may be sent node index forward lists.
+ *	Until this is called for a node, it is only sent node names.
+ * IN: node_name - node which registered
+ * IN: ok - true if its slurm.conf hash matches ours
+ */
+extern void forward_set_node_table_ok(const char *node_name, bool ok);
+
+/*
+ * forward_bitmap2hostlist - build a hostlist from node table indexes
+ * IN: nodes - bitstr_t * - nodes to convert
+ * RET hostlist_t - caller must hostlist_destroy() it
+ */
+extern hostlist_t forward_bitmap2hostlist(bitstr_t *nodes);
+
 /*
  * forward_msg	      - logic to forward a message which has been received and
  *			accumulate the return codes from processes getting the
@@ -146,6 +146,21 @@ static pthread_mutex_t gres_context_lock = PTHREAD_MUTEX_INITIALIZER;
 static List gres_conf_list = NULL;
 static bool init_run = false;
 
+/* GRES type (model) names interned to small integer IDs so that job and node
+ * type matching in the scheduling path is an integer comparison. IDs are
+ * never recycled, since they are held in job and node state records which
+ * survive a reconfiguration. */
+static pthread_mutex_t gres_type_lock = PTHREAD_MUTEX_INITIALIZER;
+static char **gres_type_names = NULL;
+static uint32_t gres_type_cnt = 0;
+
+/* Scratch space for _job_core_filter() and _job_test(), protected by
+ * gres_context_lock */
+static bitstr_t *job_test_cpu_bitmap = NULL;
+static uint32_t *job_test_cpus_addnt = NULL;
+static uint32_t *job_test_cpus_avail = NULL;
+static int job_test_topo_size = 0;
+
 /* Local functions */
 static gres_node_state_t *
 		_build_gres_node_state(void);
@@ -245,6 +260,65 @@ static uint32_t	_build_id(char *gres_name)
 	return id;
 }
 
+/* Convert a gres type (model) name into its interned ID, zero for no type */
+static uint32_t	_type_id(char *type)
+{
+	uint32_t i;
+
+	if (!type)
+		return 0;
+
+	slurm_mutex_lock(&gres_type_lock);
+	for (i = 0; i < gres_type_cnt; i++) {
+		if (!xstrcmp(gres_type_names[i], type))
+			break;
+	}
+	if (i >= gres_type_cnt) {
+		xrealloc(gres_type_names, sizeof(char *) * (gres_type_cnt + 1));
+		gres_type_names[gres_type_cnt++] = xstrdup(type);
+	}
+	slurm_mutex_unlock(&gres_type_lock);
+
+	return i + 1;
+}
+
+/* Build interned type IDs for a node's topo_model and type_model arrays if
+ * not already done (e.g. state built by an older code path) */
+static void _node_type_ids_set(gres_node_state_t *node_gres_ptr)
+{
+	int i;
+
+	if (node_gres_ptr->topo_cnt && !node_gres_ptr->topo_type_id) {
+		node_gres_ptr->topo_type_id = xmalloc(sizeof(uint32_t) *
+						      node_gres_ptr->topo_cnt);
+		for (i = 0; i < node_gres_ptr->topo_cnt; i++) {
+			node_gres_ptr->topo_type_id[i] =
+				_type_id(node_gres_ptr->topo_model[i]);
+		}
+	}
+	if (node_gres_ptr->type_cnt && !node_gres_ptr->type_id) {
+		node_gres_ptr->type_id = xmalloc(sizeof(uint32_t) *
+						 node_gres_ptr->type_cnt);
+		for (i = 0; i < node_gres_ptr->type_cnt; i++) {
+			node_gres_ptr->type_id[i] =
+				_type_id(node_gres_ptr->type_model[i]);
+		}
+	}
+}
+
+/* Return true if the job's GRES type can be satisfied by the given node
+ * topology record. Call _node_type_ids_set() first. */
+static inline bool _topo_type_match(gres_job_state_t *job_gres_ptr,
+				    gres_node_state_t *node_gres_ptr,
+				    int topo_inx)
+{
+	if (!job_gres_ptr->type_model)
+		return true;
+	if (!job_gres_ptr->type_id)
+		job_gres_ptr->type_id = _type_id(job_gres_ptr->type_model);
+	return (node_gres_ptr->topo_type_id[topo_inx] == job_gres_ptr->type_id);
+}
+
 static int _gres_find_id(void *x, void *key)
 {
 	uint32_t *plugin_id = (uint32_t *)key;
@@ -535,6 +609,10 @@ extern int gres_plugin_fini(void)
 	xfree(gres_context);
 	xfree(gres_plugin_list);
 	FREE_NULL_LIST(gres_conf_list);
+	FREE_NULL_BITMAP(job_test_cpu_bitmap);
+	xfree(job_test_cpus_addnt);
+	xfree(job_test_cpus_avail);
+	job_test_topo_size = 0;
 	gres_context_cnt = -1;
 
 fini:	slurm_mutex_unlock(&gres_context_lock);
@@ -1348,12 +1426,14 @@ static void _gres_node_list_delete(void *list_element)
 	xfree(gres_node_ptr->topo_gres_cnt_alloc);
 	xfree(gres_node_ptr->topo_gres_cnt_avail);
 	xfree(gres_node_ptr->topo_model);
+	xfree(gres_node_ptr->topo_type_id);
 	for (i = 0; i < gres_node_ptr->type_cnt; i++) {
 		xfree(gres_node_ptr->type_model[i]);
 	}
 	xfree(gres_node_ptr->type_cnt_alloc);
 	xfree(gres_node_ptr->type_cnt_avail);
 	xfree(gres_node_ptr->type_model);
+	xfree(gres_node_ptr->type_id);
 	xfree(gres_node_ptr);
 	xfree(gres_ptr);
 }
@@ -1386,8 +1466,12 @@ static void _add_gres_type(char *type, gres_node_state_t *gres_data,
 		gres_data->type_model =
 			xrealloc(gres_data->type_model,
 				 sizeof(char *) * gres_data->type_cnt);
+		gres_data->type_id =
+			xrealloc(gres_data->type_id,
+				 sizeof(uint32_t) * gres_data->type_cnt);
 		gres_data->type_cnt_avail[i] += tmp_gres_cnt;
 		gres_data->type_model[i] = xstrdup(type);
+		gres_data->type_id[i] = _type_id(type);
 	}
 }
 
@@ -1781,6 +1865,7 @@ static int _node_config_validate(char *node_name, char *orig_config,
 		xfree(gres_data->topo_gres_bitmap);
 		xfree(gres_data->topo_cpus_bitmap);
 		xfree(gres_data->topo_model);
+		xfree(gres_data->topo_type_id);
 		gres_data->topo_cnt = set_cnt;
 	}
 
@@ -1812,6 +1897,8 @@ static int _node_config_validate(char *node_name, char *orig_config,
 				 set_cnt * sizeof(bitstr_t *));
 		gres_data->topo_model = xrealloc(gres_data->topo_model,
 						 set_cnt * sizeof(char *));
+		gres_data->topo_type_id = xrealloc(gres_data->topo_type_id,
+						   set_cnt * sizeof(uint32_t));
 		gres_data->topo_cnt = set_cnt;
 
 		iter = list_iterator_create(gres_conf_list);
@@ -1841,6 +1928,8 @@ static int _node_config_validate(char *node_name, char *orig_config,
 			}
 			gres_data->topo_model[i] = xstrdup(gres_slurmd_conf->
 							   type);
+			gres_data->topo_type_id[i] =
+				_type_id(gres_slurmd_conf->type);
 			i++;
 		}
 		list_iterator_destroy(iter);
@@ -1919,6 +2008,7 @@ static int _node_config_validate(char *node_name, char *orig_config,
 			xfree(gres_data->topo_gres_cnt_alloc);
 			xfree(gres_data->topo_gres_cnt_avail);
 			xfree(gres_data->topo_model);
+			xfree(gres_data->topo_type_id);
 		}
 		gres_data->topo_cnt = 0;
 	} else if ((fast_schedule == 0) &&
@@ -2359,6 +2449,12 @@ static void *_node_state_dup(void *gres_data)
 	new_gres->topo_gres_cnt_avail = xmalloc(gres_ptr->topo_cnt *
 						sizeof(uint64_t));
 	new_gres->topo_model = xmalloc(gres_ptr->topo_cnt * sizeof(char *));
+	if (gres_ptr->topo_type_id) {
+		new_gres->topo_type_id = xmalloc(gres_ptr->topo_cnt *
+						 sizeof(uint32_t));
+		memcpy(new_gres->topo_type_id, gres_ptr->topo_type_id,
+		       gres_ptr->topo_cnt * sizeof(uint32_t));
+	}
 	for (i = 0; i < gres_ptr->topo_cnt; i++) {
 		if (gres_ptr->topo_cpus_bitmap[i]) {
 			new_gres->topo_cpus_bitmap[i] =
@@ -2379,6 +2475,12 @@ static void *_node_state_dup(void *gres_data)
 	new_gres->type_cnt_avail = xmalloc(gres_ptr->type_cnt *
 					   sizeof(uint64_t));
 	new_gres->type_model = xmalloc(gres_ptr->type_cnt * sizeof(char *));
+	if (gres_ptr->type_id) {
+		new_gres->type_id = xmalloc(gres_ptr->type_cnt *
+					    sizeof(uint32_t));
+		memcpy(new_gres->type_id, gres_ptr->type_id,
+		       gres_ptr->type_cnt * sizeof(uint32_t));
+	}
 	for (i = 0; i < gres_ptr->type_cnt; i++) {
 		new_gres->type_cnt_alloc[i] = gres_ptr->type_cnt_alloc[i];
 		new_gres->type_cnt_avail[i] = gres_ptr->type_cnt_avail[i];
@@ -2963,6 +3065,7 @@ static int _job_state_validate(char *config, gres_job_state_t **gres_data,
 		gres_ptr = xmalloc(sizeof(gres_job_state_t));
 		gres_ptr->gres_cnt_alloc = cnt;
 		gres_ptr->type_model = type;
+		gres_ptr->type_id = _type_id(type);
 
 		if (type) {
 			/* set the gres name+type id to check for duplicates
@@ -3086,6 +3189,7 @@ static void *_job_state_dup(void *gres_data)
 	new_gres_ptr->gres_cnt_alloc	= gres_ptr->gres_cnt_alloc;
 	new_gres_ptr->node_cnt		= gres_ptr->node_cnt;
 	new_gres_ptr->type_model	= xstrdup(gres_ptr->type_model);
+	new_gres_ptr->type_id		= gres_ptr->type_id;
 
 	if (gres_ptr->gres_bit_alloc) {
 		new_gres_ptr->gres_bit_alloc = xmalloc(sizeof(bitstr_t *) *
@@ -3113,6 +3217,7 @@ static void *_job_state_dup2(void *gres_data, int node_index)
 	new_gres_ptr->gres_cnt_alloc	= gres_ptr->gres_cnt_alloc;
 	new_gres_ptr->node_cnt		= 1;
 	new_gres_ptr->type_model	= xstrdup(gres_ptr->type_model);
+	new_gres_ptr->type_id		= gres_ptr->type_id;
 
 	if (gres_ptr->gres_bit_alloc && gres_ptr->gres_bit_alloc[node_index]) {
 		new_gres_ptr->gres_bit_alloc	= xmalloc(sizeof(bitstr_t *));
@@ -3311,6 +3416,8 @@ extern int gres_plugin_job_state_unpack(List *gres_list, Buf buffer,
 			safe_unpack64(&gres_job_ptr->gres_cnt_alloc, buffer);
 			safe_unpackstr_xmalloc(&gres_job_ptr->type_model,
 					       &utmp32, buffer);
+			gres_job_ptr->type_id =
+				_type_id(gres_job_ptr->type_model);
 			safe_unpack32(&gres_job_ptr->node_cnt, buffer);
 			if (gres_job_ptr->node_cnt > NO_VAL32)
 				goto unpack_error;
@@ -3454,6 +3561,36 @@ static void _validate_gres_node_cpus(gres_node_state_t *node_gres_ptr,
 	}
 }
 
+/* Size the per topology record scratch arrays for topo_cnt records and clear
+ * them. Caller holds gres_context_lock. */
+static void _topo_scratch(int topo_cnt)
+{
+	if (topo_cnt > job_test_topo_size) {
+		job_test_topo_size = topo_cnt;
+		xrealloc(job_test_cpus_addnt,
+			 sizeof(uint32_t) * job_test_topo_size);
+		xrealloc(job_test_cpus_avail,
+			 sizeof(uint32_t) * job_test_topo_size);
+	}
+	memset(job_test_cpus_addnt, 0, sizeof(uint32_t) * topo_cnt);
+	memset(job_test_cpus_avail, 0, sizeof(uint32_t) * topo_cnt);
+}
+
+/* Size the _job_test() scratch space for a node with cpu_cnt CPUs and
+ * topo_cnt topology records and clear it. Caller holds gres_context_lock. */
+static void _job_test_scratch(int cpu_cnt, int topo_cnt)
+{
+	if (!job_test_cpu_bitmap) {
+		job_test_cpu_bitmap = bit_alloc(cpu_cnt);
+	} else if (bit_size(job_test_cpu_bitmap) != cpu_cnt) {
+		job_test_cpu_bitmap = bit_realloc(job_test_cpu_bitmap,
+						  cpu_cnt);
+	}
+	if (cpu_cnt > 0)
+		bit_nclear(job_test_cpu_bitmap, 0, cpu_cnt - 1);
+	_topo_scratch(topo_cnt);
+}
+
 static void	_job_core_filter(void *job_gres_data, void *node_gres_data,
 				 bool use_total_gres, bitstr_t *cpu_bitmap,
 				 int cpu_start_bit, int cpu_end_bit,
@@ -3462,15 +3599,18 @@ static void	_job_core_filter(void *job_gres_data, void *node_gres_data,
 	int i, j, cpus_ctld;
 	gres_job_state_t  *job_gres_ptr  = (gres_job_state_t *)  job_gres_data;
 	gres_node_state_t *node_gres_ptr = (gres_node_state_t *) node_gres_data;
-	bitstr_t *avail_cpu_bitmap = NULL;
+	uint32_t *topo_usable;
+	bool any_usable = false;
 
 	if (!node_gres_ptr->topo_cnt || !cpu_bitmap ||	/* No topology info */
 	    !job_gres_ptr->gres_cnt_alloc)		/* No job GRES */
 		return;
 
-	/* Determine which specific CPUs can be used */
-	avail_cpu_bitmap = bit_copy(cpu_bitmap);
-	bit_nclear(avail_cpu_bitmap, cpu_start_bit, cpu_end_bit);
+	/* Identify the topology records usable by this job. Any usable record
+	 * lacking a CPU map means no filtering is possible. */
+	_node_type_ids_set(node_gres_ptr);
+	_topo_scratch(node_gres_ptr->topo_cnt);
+	topo_usable = job_test_cpus_avail;
 	for (i = 0; i < node_gres_ptr->topo_cnt; i++) {
 		if (node_gres_ptr->topo_gres_cnt_avail[i] == 0)
 			continue;
@@ -3478,26 +3618,30 @@ static void	_job_core_filter(void *job_gres_data, void *node_gres_data,
 		    (node_gres_ptr->topo_gres_cnt_alloc[i] >=
 		     node_gres_ptr->topo_gres_cnt_avail[i]))
 			continue;
-		if (job_gres_ptr->type_model &&
-		    (!node_gres_ptr->topo_model[i] ||
-		     xstrcmp(job_gres_ptr->type_model,
-			     node_gres_ptr->topo_model[i])))
+		if (!_topo_type_match(job_gres_ptr, node_gres_ptr, i))
 			continue;
-		if (!node_gres_ptr->topo_cpus_bitmap[i]) {
-			FREE_NULL_BITMAP(avail_cpu_bitmap);	/* No filter */
-			return;
-		}
-		cpus_ctld = cpu_end_bit - cpu_start_bit + 1;
+		if (!node_gres_ptr->topo_cpus_bitmap[i])
+			return;		/* No filter */
+		topo_usable[i] = 1;
+		any_usable = true;
+	}
+
+	/* Clear this node's CPUs not associated with any usable record */
+	cpus_ctld = cpu_end_bit - cpu_start_bit + 1;
+	if (any_usable)
 		_validate_gres_node_cpus(node_gres_ptr, cpus_ctld, node_name);
-		cpus_ctld = bit_size(node_gres_ptr->topo_cpus_bitmap[i]);
-		for (j = 0; j < cpus_ctld; j++) {
-			if (bit_test(node_gres_ptr->topo_cpus_bitmap[i], j)) {
-				bit_set(avail_cpu_bitmap, cpu_start_bit + j);
-			}
+	for (j = 0; j < cpus_ctld; j++) {
+		if (!bit_test(cpu_bitmap, cpu_start_bit + j))
+			continue;
+		for (i = 0; i < node_gres_ptr->topo_cnt; i++) {
+			if (topo_usable[i] &&
+			    (j < bit_size(node_gres_ptr->topo_cpus_bitmap[i])) &&
+			    bit_test(node_gres_ptr->topo_cpus_bitmap[i], j))
+				break;
 		}
+		if (i >= node_gres_ptr->topo_cnt)
+			bit_clear(cpu_bitmap, cpu_start_bit + j);
 	}
-	bit_and(cpu_bitmap, avail_cpu_bitmap);
-	FREE_NULL_BITMAP(avail_cpu_bitmap);
 }
 
 static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
@@ -3516,6 +3660,7 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 
 	if (node_gres_ptr->no_consume)
 		use_total_gres = true;
+	_node_type_ids_set(node_gres_ptr);
 
 	if (job_gres_ptr->gres_cnt_alloc && node_gres_ptr->topo_cnt &&
 	    *topo_set) {
@@ -3532,10 +3677,7 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 						 node_name);
 		}
 		for (i = 0; i < node_gres_ptr->topo_cnt; i++) {
-			if (job_gres_ptr->type_model &&
-			    (!node_gres_ptr->topo_model[i] ||
-			     xstrcmp(node_gres_ptr->topo_model[i],
-				     job_gres_ptr->type_model)))
+			if (!_topo_type_match(job_gres_ptr, node_gres_ptr, i))
 				continue;
 			if (!node_gres_ptr->topo_cpus_bitmap[i]) {
 				gres_avail += node_gres_ptr->
@@ -3594,7 +3736,10 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 			}
 		}
 
-		alloc_cpu_bitmap = bit_alloc(cpus_ctld);
+		_job_test_scratch(cpus_ctld, node_gres_ptr->topo_cnt);
+		alloc_cpu_bitmap = job_test_cpu_bitmap;
+		cpus_addnt = job_test_cpus_addnt;
+		cpus_avail = job_test_cpus_avail;
 		if (cpu_bitmap) {
 			for (j = 0; j < cpus_ctld; j++) {
 				if (bit_test(cpu_bitmap, cpu_start_bit+j))
@@ -3604,8 +3749,6 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 			bit_nset(alloc_cpu_bitmap, 0, cpus_ctld - 1);
 		}
 
-		cpus_addnt = xmalloc(sizeof(uint32_t)*node_gres_ptr->topo_cnt);
-		cpus_avail = xmalloc(sizeof(uint32_t)*node_gres_ptr->topo_cnt);
 		for (i = 0; i < node_gres_ptr->topo_cnt; i++) {
 			if (node_gres_ptr->topo_gres_cnt_avail[i] == 0)
 				continue;
@@ -3613,10 +3756,7 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 			    (node_gres_ptr->topo_gres_cnt_alloc[i] >=
 			     node_gres_ptr->topo_gres_cnt_avail[i]))
 				continue;
-			if (job_gres_ptr->type_model &&
-			    (!node_gres_ptr->topo_model[i] ||
-			     xstrcmp(node_gres_ptr->topo_model[i],
-				     job_gres_ptr->type_model)))
+			if (!_topo_type_match(job_gres_ptr, node_gres_ptr, i))
 				continue;
 			if (!node_gres_ptr->topo_cpus_bitmap[i]) {
 				cpus_avail[i] = cpu_end_bit - cpu_start_bit + 1;
@@ -3699,15 +3839,14 @@ static uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 					bit_clear(cpu_bitmap, cpu_start_bit+i);
 			}
 		}
-		FREE_NULL_BITMAP(alloc_cpu_bitmap);
-		xfree(cpus_addnt);
-		xfree(cpus_avail);
 		return cpu_cnt;
 	} else if (job_gres_ptr->type_model) {
+		if (!job_gres_ptr->type_id) {
+			job_gres_ptr->type_id =
+				_type_id(job_gres_ptr->type_model);
+		}
 		for (i = 0; i < node_gres_ptr->type_cnt; i++) {
-			if (node_gres_ptr->type_model[i] &&
-			    !xstrcmp(node_gres_ptr->type_model[i],
-				     job_gres_ptr->type_model))
+			if (node_gres_ptr->type_id[i] == job_gres_ptr->type_id)
 				break;
 		}
 		if (i >= node_gres_ptr->type_cnt)
@@ -3747,7 +3886,7 @@ extern void gres_plugin_job_core_filter(List job_gres_list, List node_gres_list,
 					char *node_name)
 {
 	int i;
-	ListIterator  job_gres_iter, node_gres_iter;
+	ListIterator  job_gres_iter;
 	gres_state_t *job_gres_ptr, *node_gres_ptr;
 
 	if ((job_gres_list == NULL) || (cpu_bitmap == NULL))
@@ -3762,13 +3901,8 @@ extern void gres_plugin_job_core_filter(List job_gres_list, List node_gres_list,
 	slurm_mutex_lock(&gres_context_lock);
 	job_gres_iter = list_iterator_create(job_gres_list);
 	while ((job_gres_ptr = (gres_state_t *) list_next(job_gres_iter))) {
-		node_gres_iter = list_iterator_create(node_gres_list);
-		while ((node_gres_ptr = (gres_state_t *)
-				list_next(node_gres_iter))) {
-			if (job_gres_ptr->plugin_id == node_gres_ptr->plugin_id)
-				break;
-		}
-		list_iterator_destroy(node_gres_iter);
+		node_gres_ptr = list_find_first(node_gres_list, _gres_find_id,
+						&job_gres_ptr->plugin_id);
 		if (node_gres_ptr == NULL) {
 			/* node lack resources required by the job */
 			bit_nclear(cpu_bitmap, cpu_start_bit, cpu_end_bit);
@@ -3814,7 +3948,7 @@ extern uint32_t gres_plugin_job_test(List job_gres_list, List node_gres_list,
 {
 	int i;
 	uint32_t cpu_cnt, tmp_cnt;
-	ListIterator job_gres_iter,  node_gres_iter;
+	ListIterator job_gres_iter;
 	gres_state_t *job_gres_ptr, *node_gres_ptr;
 	bool topo_set = false;
 
@@ -3829,13 +3963,8 @@ extern uint32_t gres_plugin_job_test(List job_gres_list, List node_gres_list,
 	slurm_mutex_lock(&gres_context_lock);
 	job_gres_iter = list_iterator_create(job_gres_list);
 	while ((job_gres_ptr = (gres_state_t *) list_next(job_gres_iter))) {
-		node_gres_iter = list_iterator_create(node_gres_list);
-		while ((node_gres_ptr = (gres_state_t *)
-				list_next(node_gres_iter))) {
-			if (job_gres_ptr->plugin_id == node_gres_ptr->plugin_id)
-				break;
-		}
-		list_iterator_destroy(node_gres_iter);
+		node_gres_ptr = list_find_first(node_gres_list, _gres_find_id,
+						&job_gres_ptr->plugin_id);
 		if (node_gres_ptr == NULL) {
 			/* node lack resources required by the job */
 			cpu_cnt = 0;
@@ -3889,6 +4018,7 @@ static bool _cores_on_gres(bitstr_t *core_bitmap, bitstr_t *alloc_core_bitmap,
 	if ((core_bitmap == NULL) || (node_gres_ptr->topo_cnt == 0))
 		return true;
 
+	_node_type_ids_set(node_gres_ptr);
 	for (i = 0; i < node_gres_ptr->topo_cnt; i++) {
 		if (!node_gres_ptr->topo_gres_bitmap[i])
 			continue;
@@ -3896,10 +4026,7 @@ static bool _cores_on_gres(bitstr_t *core_bitmap, bitstr_t *alloc_core_bitmap,
 			continue;
 		if (!bit_test(node_gres_ptr->topo_gres_bitmap[i], gres_inx))
 			continue;
-		if (job_gres_ptr->type_model &&
-		    (!node_gres_ptr->topo_model[i] ||
-		     xstrcmp(job_gres_ptr->type_model,
-			     node_gres_ptr->topo_model[i])))
+		if (!_topo_type_match(job_gres_ptr, node_gres_ptr, i))
 			continue;
 		if (!node_gres_ptr->topo_cpus_bitmap[i])
 			return true;
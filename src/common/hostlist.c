@@ -247,6 +247,9 @@ struct hostlist {
 /* a hostset is a wrapper around a hostlist */
 struct hostset {
 	hostlist_t hl;
+
+	/* hl ranges may be binary searched, see _hostset_searchable() */
+	int searchable;
 };
 
 struct hostlist_iterator {
@@ -382,6 +385,8 @@ static void               _iterator_advance(hostlist_iterator_t);
 static void               _iterator_advance_range(hostlist_iterator_t);
 
 static int hostset_find_host(hostset_t, const char *);
+static int _hostset_searchable(hostrange_t, hostrange_t);
+static int _hostset_find_range(hostset_t, hostname_t);
 
 /* ------[ macros ]------ */
 
@@ -2041,6 +2046,16 @@ int hostlist_push_host(hostlist_t hl, const char *str)
 	return hostlist_push_host_dims(hl, str, dims);
 }
 
+int hostlist_push_host_range(hostlist_t hl, char *prefix, unsigned long lo,
+			     unsigned long hi, int width)
+{
+	if (!hl || !prefix || (hi < lo))
+		return 0;
+	if (hostlist_push_hr(hl, prefix, lo, hi, width) < 0)
+		return 0;
+	return (int) (hi - lo + 1);
+}
+
 int hostlist_push_list(hostlist_t h1, hostlist_t h2)
 {
 	int i, n = 0;
@@ -2278,18 +2293,48 @@ int hostlist_delete(hostlist_t hl, const char *hosts)
 }
 
 
-/* XXX watch out! poor implementation follows! (fix it at some point) */
+/* delete host hn, found within range i of hostlist hl
+ * assumes that the hostlist hl has been locked by caller */
+static void _hostlist_delete_hn(hostlist_t hl, int i, hostname_t hn)
+{
+	hostrange_t hr = hl->hr[i];
+	hostrange_t new;
+
+	if (hr->singlehost) { /* this wasn't a range */
+		hostlist_delete_range(hl, i);
+	} else if ((new = hostrange_delete_host(hr, hn->num))) {
+		hostlist_insert_range(hl, new, i + 1);
+		hostrange_destroy(new);
+	} else if (hostrange_empty(hr))
+		hostlist_delete_range(hl, i);
+
+	hl->nhosts--;
+}
+
 int hostlist_delete_host(hostlist_t hl, const char *hostname)
 {
-	int n;
+	int i, retval = 0;
+	hostname_t hn;
 
 	if (!hl)
 		return -1;
-	n = hostlist_find(hl, hostname);
+	if (!hostname)
+		return 0;
+
+	hn = hostname_create(hostname);
+
+	LOCK_HOSTLIST(hl);
+	for (i = 0; i < hl->nranges; i++) {
+		if (hostrange_hn_within(hl->hr[i], hn)) {
+			_hostlist_delete_hn(hl, i, hn);
+			retval = 1;
+			break;
+		}
+	}
+	UNLOCK_HOSTLIST(hl);
 
-	if (n >= 0)
-		hostlist_delete_nth(hl, n);
-	return n >= 0 ? 1 : 0;
+	hostname_destroy(hn);
+	return retval;
 }
 
 
@@ -2349,6 +2394,28 @@ char * hostlist_nth(hostlist_t hl, int n)
 	return host;
 }
 
+int hostlist_get_range(hostlist_t hl, int n, char **prefix,
+		       unsigned long *lo, unsigned long *hi, int *width)
+{
+	hostrange_t hr;
+	int retval = -1;
+
+	if (!hl)
+		return -1;
+	LOCK_HOSTLIST(hl);
+	if ((n >= 0) && (n < hl->nranges)) {
+		hr = hl->hr[n];
+		*prefix = hr->prefix;
+		*lo = hr->lo;
+		*hi = hr->hi;
+		*width = hr->width;
+		retval = hr->singlehost ? 0 : 1;
+	}
+	UNLOCK_HOSTLIST(hl);
+
+	return retval;
+}
+
 
 int hostlist_delete_nth(hostlist_t hl, int n)
 {
@@ -3515,6 +3582,7 @@ int hostlist_remove(hostlist_iterator_t i)
 hostset_t hostset_create(const char *hostlist)
 {
 	hostset_t new;
+	int i;
 
 	if (!(new = (hostset_t) malloc(sizeof(*new)))) {
 		out_of_memory("hostset_create");
@@ -3527,6 +3595,13 @@ hostset_t hostset_create(const char *hostlist)
 	}
 
 	hostlist_uniq(new->hl);
+
+	new->searchable = (slurmdb_setup_cluster_name_dims() == 1);
+	for (i = 0; new->searchable && (i < new->hl->nranges); i++) {
+		new->searchable = _hostset_searchable(new->hl->hr[i],
+						      i ? new->hl->hr[i - 1] :
+						      NULL);
+	}
 	return new;
 }
 
@@ -3538,6 +3613,7 @@ hostset_t hostset_copy(const hostset_t set)
 
 	if (!(new->hl = hostlist_copy(set->hl)))
 		goto error2;
+	new->searchable = set->searchable;
 
 	return new;
 error2:
@@ -3565,6 +3641,7 @@ static int hostset_insert_range(hostset_t set, hostrange_t hr)
 	int inserted = 0;
 	int nhosts = 0;
 	int ndups = 0;
+	int lo, hi, mid;
 	hostlist_t hl;
 
 	hl = set->hl;
@@ -3574,7 +3651,26 @@ static int hostset_insert_range(hostset_t set, hostrange_t hr)
 
 	nhosts = hostrange_count(hr);
 
-	for (i = 0; i < hl->nranges; i++) {
+	if (set->searchable) {
+		/* binary search for the first range not less than hr */
+		lo = 0;
+		hi = hl->nranges;
+		while (lo < hi) {
+			mid = (lo + hi) / 2;
+			if (hostrange_cmp(hr, hl->hr[mid]) <= 0)
+				hi = mid;
+			else
+				lo = mid + 1;
+		}
+		if (_hostset_searchable(hr, lo ? hl->hr[lo - 1] : NULL) &&
+		    ((lo == hl->nranges) ||
+		     _hostset_searchable(hl->hr[lo], hr)))
+			i = lo;
+		else
+			set->searchable = 0;
+	}
+
+	for ( ; i < hl->nranges; i++) {
 		if (hostrange_cmp(hr, hl->hr[i]) <= 0) {
 
 			if ((ndups = hostrange_join(hr, hl->hr[i])) >= 0)
@@ -3628,7 +3724,75 @@ int hostset_insert(hostset_t set, const char *hosts)
 }
 
 
-/* linear search through N ranges for hostname "host"
+/* return true if the sorted ranges of a hostset stay in order of prefix
+ * and then of lo when range hr follows range prev. This holds unless
+ * prefixes end in digits (see hostrange_hn_within()), prefixes compare
+ * equal without being identical, or widths differ within one prefix.
+ */
+static int _hostset_searchable(hostrange_t hr, hostrange_t prev)
+{
+	int len = strlen(hr->prefix);
+
+	if (!hr->singlehost && len && isdigit((int)hr->prefix[len - 1]))
+		return 0;
+	if (!prev || strnatcmp(prev->prefix, hr->prefix))
+		return 1;
+	if (strcmp(prev->prefix, hr->prefix))
+		return 0;
+	if (!prev->singlehost && !hr->singlehost && (prev->width != hr->width))
+		return 0;
+	return 1;
+}
+
+/* binary search through the ranges of a searchable hostset
+ * returns the index of the range holding hn, or -1 if not found
+ * assumes that the set->hl lock is already held
+ */
+static int _hostset_find_range(hostset_t set, hostname_t hn)
+{
+	hostlist_t hl = set->hl;
+	int lo, hi, mid, first;
+
+	/* first range with hn's prefix, singlehosts sort before ranges */
+	lo = 0;
+	hi = hl->nranges;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (strnatcmp(hl->hr[mid]->prefix, hn->prefix) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (!hostname_suffix_is_valid(hn)) {
+		for ( ; (lo < hl->nranges) && hl->hr[lo]->singlehost; lo++) {
+			if (hostrange_hn_within(hl->hr[lo], hn))
+				return lo;
+		}
+		return -1;
+	}
+
+	while ((lo < hl->nranges) && hl->hr[lo]->singlehost)
+		lo++;
+	first = lo;
+
+	/* last range with hn's prefix and lo not above hn's suffix */
+	hi = hl->nranges;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (strnatcmp(hl->hr[mid]->prefix, hn->prefix) ||
+		    (hl->hr[mid]->lo > hn->num))
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	if ((lo > first) && hostrange_hn_within(hl->hr[lo - 1], hn))
+		return lo - 1;
+	return -1;
+}
+
+/* search through N ranges for hostname "host"
  * */
 static int hostset_find_host(hostset_t set, const char *host)
 {
@@ -3637,6 +3801,10 @@ static int hostset_find_host(hostset_t set, const char *host)
 	hostname_t hn;
 	LOCK_HOSTLIST(set->hl);
 	hn = hostname_create(host);
+	if (set->searchable) {
+		retval = (_hostset_find_range(set, hn) >= 0);
+		goto done;
+	}
 	for (i = 0; i < set->hl->nranges; i++) {
 		if (hostrange_hn_within(set->hl->hr[i], hn)) {
 			retval = 1;
@@ -3695,12 +3863,41 @@ int hostset_within(hostset_t set, const char *hosts)
 
 int hostset_delete(hostset_t set, const char *hosts)
 {
-	return hostlist_delete(set->hl, hosts);
+	int n = 0;
+	char *hostname = NULL;
+	hostlist_t hltmp;
+
+	if (!set->searchable)
+		return hostlist_delete(set->hl, hosts);
+
+	if (!(hltmp = hostlist_create(hosts)))
+		seterrno_ret(EINVAL, 0);
+
+	while ((hostname = hostlist_pop(hltmp)) != NULL) {
+		n += hostset_delete_host(set, hostname);
+		free(hostname);
+	}
+	hostlist_destroy(hltmp);
+
+	return n;
 }
 
 int hostset_delete_host(hostset_t set, const char *hostname)
 {
-	return hostlist_delete_host(set->hl, hostname);
+	int i;
+	hostname_t hn;
+
+	if (!set->searchable || !hostname)
+		return hostlist_delete_host(set->hl, hostname);
+
+	hn = hostname_create(hostname);
+	LOCK_HOSTLIST(set->hl);
+	if ((i = _hostset_find_range(set, hn)) >= 0)
+		_hostlist_delete_hn(set->hl, i, hn);
+	UNLOCK_HOSTLIST(set->hl);
+	hostname_destroy(hn);
+
+	return (i >= 0) ? 1 : 0;
 }
 
 char *hostset_shift(hostset_t set)
@@ -3745,7 +3942,26 @@ char * hostset_nth(hostset_t set, int n)
 
 int hostset_find(hostset_t set, const char *hostname)
 {
-	return hostlist_find(set->hl, hostname);
+	int i, n, count = 0, ret = -1;
+	hostname_t hn;
+
+	if (!set->searchable || !hostname)
+		return hostlist_find(set->hl, hostname);
+
+	hn = hostname_create(hostname);
+	LOCK_HOSTLIST(set->hl);
+	if ((n = _hostset_find_range(set, hn)) >= 0) {
+		for (i = 0; i < n; i++)
+			count += hostrange_count(set->hl->hr[i]);
+		if (hostname_suffix_is_valid(hn))
+			ret = count + hn->num - set->hl->hr[n]->lo;
+		else
+			ret = count;
+	}
+	UNLOCK_HOSTLIST(set->hl);
+	hostname_destroy(hn);
+
+	return ret;
 }
 
 #if TEST_MAIN
@@ -203,6 +203,18 @@ int hostlist_push_host_dims(hostlist_t hl, const char *str, int dims);
 int hostlist_push_host(hostlist_t hl, const char *host);
 
 
+/* hostlist_push_host_range():
+ *
+ * Push the hosts named "prefix" followed by each number from "lo" to "hi",
+ * zero padded to "width", onto the hostlist hl without building each
+ * host name.
+ *
+ * Returns the number of hosts pushed, or 0 on failure.
+ */
+int hostlist_push_host_range(hostlist_t hl, char *prefix, unsigned long lo,
+			     unsigned long hi, int width);
+
+
 /* hostlist_push_list():
  *
  * Push a hostlist (hl2) onto another list (hl1)
@@ -226,6 +238,20 @@ char * hostlist_pop(hostlist_t hl);
 
 char * hostlist_nth(hostlist_t hl, int n);
 
+/* hostlist_get_range():
+ *
+ * Returns the prefix, numeric suffix bounds and suffix width of range "n"
+ * of hostlist "hl", for callers that translate whole ranges rather than
+ * expanding them one host at a time. "prefix" points into "hl" and is only
+ * valid until "hl" is modified.
+ *
+ * Returns 1 for a range of hosts named "prefix" followed by a number from
+ * "lo" to "hi" zero padded to "width", 0 for a single host named "prefix",
+ * or -1 if the hostlist has no range "n".
+ */
+int hostlist_get_range(hostlist_t hl, int n, char **prefix,
+		       unsigned long *lo, unsigned long *hi, int *width);
+
 /* hostlist_shift():
  *
  * Returns the string representation of the first host in the hostlist
@@ -506,6 +532,12 @@ int hostset_insert(hostset_t set, const char *hosts);
  */
 int hostset_delete(hostset_t set, const char *hosts);
 
+/* hostset_delete_host():
+ * Delete a single host from hostset "set."
+ * Returns 1 if the host was deleted, 0 if it was not in the set.
+ */
+int hostset_delete_host(hostset_t set, const char *hostname);
+
 /* hostset_intersects():
  * Return 1 if any of the hosts specified by "hosts" are within the hostset "set"
  * Return 0 if all host in "hosts" is not in the hostset "set"
@@ -67,6 +67,7 @@
 #include "src/common/slurm_acct_gather_energy.h"
 #include "src/common/slurm_ext_sensors.h"
 #include "src/common/slurm_topology.h"
+#include "src/common/working_cluster.h"
 #include "src/common/xassert.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
@@ -83,6 +84,24 @@ int node_record_count = 0;		/* count in node_record_table_ptr */
 uint16_t *cr_node_num_cores = NULL;
 uint32_t *cr_node_cores_offset = NULL;
 
+/*
+ * Runs of consecutive node records whose names differ only in a numeric
+ * suffix, e.g. "nid00001" through "nid10000". These let a ranged node
+ * expression be translated into bitmap ranges without expanding each name.
+ * Sorted by prefix, width and lo.
+ */
+typedef struct {
+	char *prefix;		/* node name up to its numeric suffix */
+	int width;		/* suffix digits of the first node name */
+	unsigned long lo;	/* suffix of the first node name */
+	unsigned long hi;	/* suffix of the last node name */
+	int first_inx;		/* node table index of the first node name */
+} node_name_run_t;
+
+static node_name_run_t *node_name_runs = NULL;
+static int node_name_run_cnt = 0;
+static int *node_run_inx = NULL;	/* node_name_runs index of each node */
+
 /* Local function defiitions */
 static int	_build_single_nodeline_info(slurm_conf_node_t *node_ptr,
 					    struct config_record *config_ptr);
@@ -96,6 +115,10 @@ static struct node_record *
 		_find_node_record (char *name,bool test_alias,bool log_missing);
 static void	_list_delete_config (void *config_entry);
 static int	_list_find_config (void *config_entry, void *key);
+static void	_build_name_runs(void);
+static void	_free_name_runs(void);
+static int	_hostlist2bitmap_ranges(hostlist_t hl, bool best_effort,
+					bitstr_t *bitmap, const char *caller);
 
 /*
  * _build_single_nodeline_info - From the slurm.conf reader, build table,
@@ -424,6 +447,22 @@ hostlist_t bitmap2hostlist (bitstr_t *bitmap)
 	for (i = first; i <= last; i++) {
 		if (bit_test(bitmap, i) == 0)
 			continue;
+		if (node_run_inx && (node_run_inx[i] >= 0)) {
+			/* push the set bits within this name run at once */
+			node_name_run_t *run = &node_name_runs[node_run_inx[i]];
+			int j = i, run_last = run->first_inx +
+					      (int) (run->hi - run->lo);
+
+			while ((j < MIN(last, run_last)) &&
+			       bit_test(bitmap, j + 1))
+				j++;
+			hostlist_push_host_range(hl, run->prefix,
+						 run->lo + (i - run->first_inx),
+						 run->lo + (j - run->first_inx),
+						 run->width);
+			i = j;
+			continue;
+		}
 		hostlist_push_host(hl, node_record_table_ptr[i].name);
 	}
 	return hl;
@@ -828,6 +867,7 @@ extern int init_node_conf (void)
 	node_record_count = 0;
 	xfree(node_record_table_ptr);
 	xhash_free(node_hash_table);
+	_free_name_runs();
 
 	if (config_list)	/* delete defunct configuration entries */
 		(void) _delete_config_record ();
@@ -852,6 +892,7 @@ extern void node_fini2 (void)
 	}
 
 	xhash_free(node_hash_table);
+	_free_name_runs();
 	node_ptr = node_record_table_ptr;
 	for (i = 0; i < node_record_count; i++, node_ptr++)
 		purge_node_rec(node_ptr);
@@ -894,6 +935,13 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 		return rc;
 	}
 
+	if (node_name_run_cnt) {
+		rc = _hostlist2bitmap_ranges(host_list, best_effort, my_bitmap,
+					     "node_name2bitmap");
+		hostlist_destroy(host_list);
+		return rc;
+	}
+
 	while ( (this_node_name = hostlist_shift (host_list)) ) {
 		struct node_record *node_ptr;
 		node_ptr = _find_node_record(this_node_name, best_effort, true);
@@ -931,6 +979,10 @@ extern int hostlist2bitmap (hostlist_t hl, bool best_effort, bitstr_t **bitmap)
 	my_bitmap = (bitstr_t *) bit_alloc (node_record_count);
 	*bitmap = my_bitmap;
 
+	if (node_name_run_cnt)
+		return _hostlist2bitmap_ranges(hl, best_effort, my_bitmap,
+					       "hostlist2bitmap");
+
 	hi = hostlist_iterator_create(hl);
 	while ((name = hostlist_next(hi)) != NULL) {
 		struct node_record *node_ptr;
@@ -978,6 +1030,265 @@ extern void purge_node_rec (struct node_record *node_ptr)
 	xfree(node_ptr->tres_cnt);
 }
 
+static void _free_name_runs(void)
+{
+	int i;
+
+	for (i = 0; i < node_name_run_cnt; i++)
+		xfree(node_name_runs[i].prefix);
+	xfree(node_name_runs);
+	xfree(node_run_inx);
+	node_name_run_cnt = 0;
+}
+
+/* Number of decimal digits in num */
+static int _num_digits(unsigned long num)
+{
+	int digits = 1;
+
+	while (num /= 10)
+		digits++;
+	return digits;
+}
+
+/*
+ * Split a node name into the length of its prefix and its numeric suffix,
+ * the way hostlist_create() splits a single dimension host name.
+ * RET false if the name has no numeric suffix
+ */
+static bool _split_node_name(const char *name, int *prefix_len,
+			     unsigned long *num, int *width)
+{
+	int len = strlen(name), i = len;
+
+	while ((i > 0) && isdigit((int) name[i - 1]))
+		i--;
+	if ((i == len) || ((len - i) > 18))
+		return false;
+
+	*prefix_len = i;
+	*width = len - i;
+	*num = strtoul(name + i, NULL, 10);
+	return true;
+}
+
+static int _cmp_name_run(const void *x, const void *y)
+{
+	const node_name_run_t *run1 = x, *run2 = y;
+	int rc;
+
+	if ((rc = xstrcmp(run1->prefix, run2->prefix)))
+		return rc;
+	if (run1->width != run2->width)
+		return (run1->width < run2->width) ? -1 : 1;
+	if (run1->lo != run2->lo)
+		return (run1->lo < run2->lo) ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Build node_name_runs from node_record_table_ptr. A run is extended while
+ * each next record's name is the previous suffix plus one, printed with
+ * the width of the run's first name as hostlist_create() would print it.
+ */
+static void _build_name_runs(void)
+{
+	node_name_run_t *run = NULL;
+	struct node_record *node_ptr = node_record_table_ptr;
+	int i, prefix_len, width, run_size = 0;
+	unsigned long num;
+
+	_free_name_runs();
+	if (slurmdb_setup_cluster_name_dims() != 1)
+		return;
+
+	for (i = 0; i < node_record_count; i++, node_ptr++) {
+		if (!node_ptr->name || !node_ptr->name[0] ||
+		    !_split_node_name(node_ptr->name, &prefix_len, &num,
+				      &width)) {
+			run = NULL;
+			continue;
+		}
+		if (run && (num == run->hi + 1) &&
+		    (width == MAX(run->width, _num_digits(num))) &&
+		    (strlen(run->prefix) == prefix_len) &&
+		    !strncmp(run->prefix, node_ptr->name, prefix_len)) {
+			run->hi = num;
+			continue;
+		}
+
+		if (node_name_run_cnt >= run_size) {
+			run_size = MAX(run_size * 2, 64);
+			xrealloc(node_name_runs,
+				 sizeof(node_name_run_t) * run_size);
+		}
+		run = &node_name_runs[node_name_run_cnt++];
+		run->prefix = xstrndup(node_ptr->name, prefix_len);
+		run->width = width;
+		run->lo = num;
+		run->hi = num;
+		run->first_inx = i;
+	}
+
+	qsort(node_name_runs, node_name_run_cnt, sizeof(node_name_run_t),
+	      _cmp_name_run);
+
+	node_run_inx = xmalloc(sizeof(int) * (node_record_count + 1));
+	for (i = 0; i < node_record_count; i++)
+		node_run_inx[i] = -1;
+	for (i = 0; i < node_name_run_cnt; i++) {
+		run = &node_name_runs[i];
+		for (num = 0; num <= run->hi - run->lo; num++)
+			node_run_inx[run->first_inx + num] = i;
+	}
+}
+
+typedef struct {
+	unsigned long lo, hi;
+} num_span_t;
+
+static int _cmp_num_span(const void *x, const void *y)
+{
+	const num_span_t *span1 = x, *span2 = y;
+
+	if (span1->lo != span2->lo)
+		return (span1->lo < span2->lo) ? -1 : 1;
+	return 0;
+}
+
+/* Set the bit of a single node name, looked up by name and alias */
+static int _name2bitmap(char *name, bool best_effort, bitstr_t *bitmap,
+			const char *caller)
+{
+	struct node_record *node_ptr;
+
+	node_ptr = _find_node_record(name, best_effort, true);
+	if (node_ptr) {
+		bit_set(bitmap, (bitoff_t) (node_ptr - node_record_table_ptr));
+		return SLURM_SUCCESS;
+	}
+	error("%s: invalid node specified %s", caller, name);
+	return best_effort ? SLURM_SUCCESS : EINVAL;
+}
+
+/*
+ * Set the bits of nodes prefix[lo-hi], numbers printed zero padded to
+ * width. Numbers covered by node_name_runs are set as whole bitmap ranges,
+ * any others (aliases, unknown names) are looked up one at a time.
+ */
+static int _name_range2bitmap(char *prefix, unsigned long lo,
+			      unsigned long hi, int width, bool best_effort,
+			      bitstr_t *bitmap, const char *caller)
+{
+	node_name_run_t *run;
+	num_span_t *spans = NULL;
+	int first, last, mid, i, j, span_cnt = 0, span_size = 0;
+	int rc = SLURM_SUCCESS;
+	unsigned long min_num, start, end, num;
+	char *name;
+
+	/* first run with this prefix */
+	first = 0;
+	last = node_name_run_cnt;
+	while (first < last) {
+		mid = (first + last) / 2;
+		if (xstrcmp(node_name_runs[mid].prefix, prefix) < 0)
+			first = mid + 1;
+		else
+			last = mid;
+	}
+
+	while ((first < node_name_run_cnt) &&
+	       !xstrcmp(node_name_runs[first].prefix, prefix)) {
+		/* runs of one width, sorted by lo without overlapping */
+		for (last = first + 1; last < node_name_run_cnt; last++) {
+			if ((node_name_runs[last].width !=
+			     node_name_runs[first].width) ||
+			    xstrcmp(node_name_runs[last].prefix, prefix))
+				break;
+		}
+
+		/* Names printed with different widths only agree once the
+		 * number has at least as many digits as the wider one */
+		min_num = lo;
+		if (width != node_name_runs[first].width) {
+			for (num = 1, i = 1;
+			     i < MAX(width, node_name_runs[first].width); i++)
+				num *= 10;
+			min_num = MAX(lo, num);
+		}
+
+		i = first;
+		j = last;
+		while (i < j) {
+			mid = (i + j) / 2;
+			if (node_name_runs[mid].hi < min_num)
+				i = mid + 1;
+			else
+				j = mid;
+		}
+		for ( ; (i < last) && (node_name_runs[i].lo <= hi); i++) {
+			run = &node_name_runs[i];
+			start = MAX(run->lo, min_num);
+			end = MIN(run->hi, hi);
+			if (start > end)
+				continue;
+			bit_nset(bitmap, run->first_inx + (start - run->lo),
+				 run->first_inx + (end - run->lo));
+			if (span_cnt >= span_size) {
+				span_size = MAX(span_size * 2, 16);
+				xrealloc(spans, sizeof(num_span_t) * span_size);
+			}
+			spans[span_cnt].lo = start;
+			spans[span_cnt].hi = end;
+			span_cnt++;
+		}
+		first = last;
+	}
+
+	/* look up whatever numbers the runs did not cover */
+	qsort(spans, span_cnt, sizeof(num_span_t), _cmp_num_span);
+	num = lo;
+	for (i = 0; i <= span_cnt; i++) {
+		end = (i < span_cnt) ? spans[i].lo : (hi + 1);
+		for ( ; num < end; num++) {
+			name = xstrdup_printf("%s%0*lu", prefix, width, num);
+			if (_name2bitmap(name, best_effort, bitmap, caller))
+				rc = EINVAL;
+			xfree(name);
+		}
+		if (i < span_cnt)
+			num = spans[i].hi + 1;
+	}
+	xfree(spans);
+
+	return rc;
+}
+
+/*
+ * Translate a hostlist into bitmap ranges one hostlist range at a time,
+ * see _name_range2bitmap()
+ */
+static int _hostlist2bitmap_ranges(hostlist_t hl, bool best_effort,
+				   bitstr_t *bitmap, const char *caller)
+{
+	int i, rc = SLURM_SUCCESS, width, range;
+	unsigned long lo, hi;
+	char *prefix;
+
+	for (i = 0; (range = hostlist_get_range(hl, i, &prefix, &lo, &hi,
+						&width)) >= 0; i++) {
+		if (range == 0) {
+			if (_name2bitmap(prefix, best_effort, bitmap, caller))
+				rc = EINVAL;
+		} else if (_name_range2bitmap(prefix, lo, hi, width,
+					      best_effort, bitmap, caller))
+			rc = EINVAL;
+	}
+
+	return rc;
+}
+
 /*
  * rehash_node - build a hash table of the node_record entries.
  * NOTE: using xhash implementation
@@ -996,6 +1307,7 @@ extern void rehash_node (void)
 			continue;	/* vestigial record */
 		xhash_add(node_hash_table, node_ptr);
 	}
+	_build_name_runs();
 
 #if _DEBUG
 	_dump_hash();
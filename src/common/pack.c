@@ -169,6 +169,67 @@ void *xfer_buf_data(Buf my_buf)
 	return data_ptr;
 }
 
+/*
+ * A small cache of buffers used for packing outgoing messages. Every RPC
+ * otherwise allocates (and zeroes) a fresh BUF_SIZE buffer, grows it as the
+ * message is appended and frees it once sent. Buffers returned here keep
+ * their allocation, so a thread sending a reply reuses memory already
+ * grown to a typical message size. Buffers that grew beyond
+ * BUF_CACHE_MAX_SIZE are released rather than pinned in the cache.
+ */
+#define BUF_CACHE_CNT		16
+#define BUF_CACHE_MAX_SIZE	(BUF_SIZE * 64)
+
+static pthread_mutex_t buf_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static Buf buf_cache[BUF_CACHE_CNT];
+static int buf_cache_cnt = 0;
+
+/* init_cached_buf - return an empty buffer, recycled if one is available.
+ * Release it with free_cached_buf() */
+Buf init_cached_buf(void)
+{
+	Buf my_buf = NULL;
+
+	slurm_mutex_lock(&buf_cache_lock);
+	if (buf_cache_cnt)
+		my_buf = buf_cache[--buf_cache_cnt];
+	slurm_mutex_unlock(&buf_cache_lock);
+
+	if (!my_buf)
+		return init_buf(BUF_SIZE);
+
+	my_buf->processed = 0;
+	return my_buf;
+}
+
+/* free_cached_buf - return a buffer from init_cached_buf() to the cache */
+void free_cached_buf(Buf my_buf)
+{
+	if (!my_buf)
+		return;
+	assert(my_buf->magic == BUF_MAGIC);
+
+	if (my_buf->size <= BUF_CACHE_MAX_SIZE) {
+		slurm_mutex_lock(&buf_cache_lock);
+		if (buf_cache_cnt < BUF_CACHE_CNT) {
+			buf_cache[buf_cache_cnt++] = my_buf;
+			my_buf = NULL;
+		}
+		slurm_mutex_unlock(&buf_cache_lock);
+	}
+
+	free_buf(my_buf);
+}
+
+/* fini_buf_cache - release all cached buffers */
+void fini_buf_cache(void)
+{
+	slurm_mutex_lock(&buf_cache_lock);
+	while (buf_cache_cnt)
+		free_buf(buf_cache[--buf_cache_cnt]);
+	slurm_mutex_unlock(&buf_cache_lock);
+}
+
 /*
  * Given a time_t in host byte order, promote it to int64_t, convert to
  * network byte order, store in buffer and adjust buffer acc'd'ngly
@@ -932,3 +993,223 @@ int unpackmem_array(char *valp, uint32_t size_valp, Buf buffer)
 		return SLURM_ERROR;
 	}
 }
+
+static uint32_t _fixed_field_size(pack_field_type_t type)
+{
+	switch (type) {
+	case PACK_FIELD_8:
+		return sizeof(uint8_t);
+	case PACK_FIELD_16:
+		return sizeof(uint16_t);
+	case PACK_FIELD_32:
+		return sizeof(uint32_t);
+	case PACK_FIELD_64:
+		return sizeof(uint64_t);
+	case PACK_FIELD_TIME:
+		return sizeof(int64_t);
+	default:
+		return 0;
+	}
+}
+
+/* Size of the structure member a field of the given type refers to */
+static inline uint32_t _member_size(pack_field_type_t type)
+{
+	if (type == PACK_FIELD_TIME)
+		return sizeof(time_t);
+	if (type == PACK_FIELD_STR)
+		return sizeof(char *);
+	return _fixed_field_size(type);
+}
+
+/*
+ * Size the record and note the length packed for each string field in
+ * str_len (if set). A string too large to pack gets NO_VAL32 there and, as
+ * with packstr(), nothing is packed for it.
+ */
+static uint32_t _pack_fields_size(const pack_field_t *fields, int cnt,
+				  void *obj, uint32_t *str_len)
+{
+	uint32_t size = 0, len;
+	char *str;
+	int i;
+
+	for (i = 0; i < cnt; i++) {
+		xassert(fields[i].size == _member_size(fields[i].type));
+		if (fields[i].type != PACK_FIELD_STR) {
+			size += _fixed_field_size(fields[i].type);
+			continue;
+		}
+		str = *(char **) ((char *) obj + fields[i].offset);
+		len = str ? (strlen(str) + 1) : 0;
+		if (len > MAX_PACK_MEM_LEN) {
+			error("%s: Buffer to be packed is too large (%u > %u)",
+			      __func__, len, MAX_PACK_MEM_LEN);
+			len = NO_VAL32;
+		} else
+			size += sizeof(uint32_t) + len;
+		if (str_len)
+			str_len[i] = len;
+	}
+
+	return size;
+}
+
+/*
+ * Return the number of bytes pack_fields() will write for the given record
+ */
+uint32_t pack_fields_size(const pack_field_t *fields, int cnt, void *obj)
+{
+	return _pack_fields_size(fields, cnt, obj, NULL);
+}
+
+/*
+ * Pack every field of the record described by fields into buffer, growing
+ * the buffer at most once.
+ */
+void pack_fields(const pack_field_t *fields, int cnt, void *obj, Buf buffer)
+{
+	uint32_t str_len[PACK_FIELDS_MAX];
+	uint32_t need, n32;
+	char *base = (char *) obj, *ptr;
+	uint16_t n16;
+	uint64_t n64;
+	int i;
+
+	xassert(cnt <= PACK_FIELDS_MAX);
+	need = _pack_fields_size(fields, cnt, obj, str_len);
+	if (remaining_buf(buffer) < need) {
+		grow_buf(buffer, need - remaining_buf(buffer) + BUF_SIZE);
+		if (remaining_buf(buffer) < need)
+			return;
+	}
+
+	ptr = &buffer->head[buffer->processed];
+	for (i = 0; i < cnt; i++) {
+		void *val = base + fields[i].offset;
+
+		switch (fields[i].type) {
+		case PACK_FIELD_8:
+			*ptr++ = *(uint8_t *) val;
+			break;
+		case PACK_FIELD_16:
+			n16 = htons(*(uint16_t *) val);
+			memcpy(ptr, &n16, sizeof(n16));
+			ptr += sizeof(n16);
+			break;
+		case PACK_FIELD_32:
+			n32 = htonl(*(uint32_t *) val);
+			memcpy(ptr, &n32, sizeof(n32));
+			ptr += sizeof(n32);
+			break;
+		case PACK_FIELD_64:
+			n64 = HTON_uint64(*(uint64_t *) val);
+			memcpy(ptr, &n64, sizeof(n64));
+			ptr += sizeof(n64);
+			break;
+		case PACK_FIELD_TIME:
+			n64 = HTON_int64((int64_t) *(time_t *) val);
+			memcpy(ptr, &n64, sizeof(n64));
+			ptr += sizeof(n64);
+			break;
+		case PACK_FIELD_STR:
+			if (str_len[i] == NO_VAL32)
+				break;
+			n32 = htonl(str_len[i]);
+			memcpy(ptr, &n32, sizeof(n32));
+			ptr += sizeof(n32);
+			if (str_len[i]) {
+				memcpy(ptr, *(char **) val, str_len[i]);
+				ptr += str_len[i];
+			}
+			break;
+		}
+	}
+	buffer->processed = ptr - buffer->head;
+}
+
+/*
+ * Unpack the record described by fields from buffer into obj. Strings are
+ * allocated with xmalloc and are left for the caller to free on error.
+ */
+int unpack_fields(const pack_field_t *fields, int cnt, void *obj, Buf buffer)
+{
+	char *base = (char *) obj, *ptr;
+	uint16_t n16;
+	uint32_t n32, run;
+	uint64_t n64;
+	int i, j;
+
+	for (i = 0; i < cnt; ) {
+		if (fields[i].type == PACK_FIELD_STR) {
+			char **str = (char **) (base + fields[i].offset);
+
+			/* As unpackmem_xmalloc() */
+			if (remaining_buf(buffer) < sizeof(n32))
+				return SLURM_ERROR;
+			memcpy(&n32, &buffer->head[buffer->processed],
+			       sizeof(n32));
+			n32 = ntohl(n32);
+			buffer->processed += sizeof(n32);
+			if (n32 > MAX_PACK_MEM_LEN) {
+				error("%s: Buffer to be unpacked is too large "
+				      "(%u > %u)", __func__, n32,
+				      MAX_PACK_MEM_LEN);
+				return SLURM_ERROR;
+			} else if (n32 > 0) {
+				if (remaining_buf(buffer) < n32)
+					return SLURM_ERROR;
+				*str = xmalloc_nz(n32);
+				memcpy(*str, &buffer->head[buffer->processed],
+				       n32);
+				buffer->processed += n32;
+			} else
+				*str = NULL;
+			i++;
+			continue;
+		}
+
+		/* Bounds check a whole run of fixed width fields at once */
+		run = 0;
+		for (j = i; (j < cnt) && (fields[j].type != PACK_FIELD_STR); j++)
+			run += _fixed_field_size(fields[j].type);
+		if (remaining_buf(buffer) < run)
+			return SLURM_ERROR;
+
+		ptr = &buffer->head[buffer->processed];
+		for ( ; i < j; i++) {
+			void *val = base + fields[i].offset;
+
+			switch (fields[i].type) {
+			case PACK_FIELD_8:
+				*(uint8_t *) val = *(uint8_t *) ptr++;
+				break;
+			case PACK_FIELD_16:
+				memcpy(&n16, ptr, sizeof(n16));
+				*(uint16_t *) val = ntohs(n16);
+				ptr += sizeof(n16);
+				break;
+			case PACK_FIELD_32:
+				memcpy(&n32, ptr, sizeof(n32));
+				*(uint32_t *) val = ntohl(n32);
+				ptr += sizeof(n32);
+				break;
+			case PACK_FIELD_64:
+				memcpy(&n64, ptr, sizeof(n64));
+				*(uint64_t *) val = NTOH_uint64(n64);
+				ptr += sizeof(n64);
+				break;
+			case PACK_FIELD_TIME:
+				memcpy(&n64, ptr, sizeof(n64));
+				*(time_t *) val = (time_t) NTOH_int64(n64);
+				ptr += sizeof(n64);
+				break;
+			default:
+				break;
+			}
+		}
+		buffer->processed += run;
+	}
+
+	return SLURM_SUCCESS;
+}
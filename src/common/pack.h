@@ -43,6 +43,7 @@
 
 #include <assert.h>
 #include <inttypes.h>
+#include <stddef.h>
 #include <time.h>
 #include <string.h>
 
@@ -79,6 +80,11 @@ Buf	init_buf(uint32_t size);
 void    grow_buf (Buf my_buf, uint32_t size);
 void	*xfer_buf_data(Buf my_buf);
 
+/* Recycled buffers for short lived message packing, see pack.c */
+Buf	init_cached_buf(void);
+void	free_cached_buf(Buf my_buf);
+void	fini_buf_cache(void);
+
 void	pack_time(time_t val, Buf buffer);
 int	unpack_time(time_t *valp, Buf buffer);
 
@@ -131,6 +137,51 @@ int	unpackstr_array(char ***valp, uint32_t* size_val, Buf buffer);
 void	packmem_array(char *valp, uint32_t size_val, Buf buffer);
 int	unpackmem_array(char *valp, uint32_t size_valp, Buf buffer);
 
+/*
+ * Table driven packing. A record is described by an array of pack_field_t,
+ * each entry naming the wire type of one structure member and its offset.
+ * pack_fields() sizes the whole record up front and grows the buffer at
+ * most once, then copies each field without further bounds checks.
+ * unpack_fields() checks the remaining length once per run of fixed width
+ * fields. The wire format is identical to calling pack8(), pack16(),
+ * pack32(), pack64(), pack_time() and packstr() on each field in order.
+ */
+typedef enum {
+	PACK_FIELD_8,
+	PACK_FIELD_16,
+	PACK_FIELD_32,
+	PACK_FIELD_64,
+	PACK_FIELD_TIME,
+	PACK_FIELD_STR		/* char *, unpacked with xmalloc */
+} pack_field_type_t;
+
+typedef struct {
+	pack_field_type_t type;
+	uint16_t offset;
+	uint16_t size;		/* sizeof member, used for sanity checks */
+} pack_field_t;
+
+#define PACK_FIELD(_type, _struct, _member)				\
+	{ PACK_FIELD_##_type, offsetof(_struct, _member),		\
+	  sizeof(((_struct *) 0)->_member) }
+
+#define PACK_FIELD_CNT(_fields)	(sizeof(_fields) / sizeof(pack_field_t))
+
+/* Most fields a single pack_fields() table may have */
+#define PACK_FIELDS_MAX 64
+
+uint32_t pack_fields_size(const pack_field_t *fields, int cnt, void *obj);
+void	pack_fields(const pack_field_t *fields, int cnt, void *obj,
+		    Buf buffer);
+int	unpack_fields(const pack_field_t *fields, int cnt, void *obj,
+		      Buf buffer);
+
+#define safe_unpack_fields(fields,cnt,obj,buf) do {	\
+	assert(buf->magic == BUF_MAGIC);		\
+	if (unpack_fields(fields,cnt,obj,buf))		\
+		goto unpack_error;			\
+} while (0)
+
 #define safe_unpack_time(valp,buf) do {			\
 	assert(sizeof(*valp) == sizeof(time_t));	\
 	assert(buf->magic == BUF_MAGIC);		\
@@ -127,6 +127,7 @@ typedef struct names_ll_s {
 	uint64_t mem_spec_limit;
 	slurm_addr_t addr;
 	bool addr_initialized;
+	int index;	/* position in node_index_tbl or -1 */
 	struct names_ll_s *next_alias;
 	struct names_ll_s *next_hostname;
 } names_ll_t;
@@ -134,6 +135,12 @@ static bool nodehash_initialized = false;
 static names_ll_t *host_to_node_hashtbl[NAME_HASH_LEN] = {NULL};
 static names_ll_t *node_to_host_hashtbl[NAME_HASH_LEN] = {NULL};
 
+/* NodeNames in configuration order, used to refer to nodes by index */
+static names_ll_t **node_index_tbl = NULL;
+static int node_index_cnt = 0;
+static int node_index_size = 0;
+static uint32_t node_index_hash = 0;
+
 static void _destroy_nodename(void *ptr);
 static int _parse_frontend(void **dest, slurm_parser_enum_t type,
 			   const char *key, const char *value,
@@ -1534,6 +1541,10 @@ static void _free_name_hashtbl(void)
 		node_to_host_hashtbl[i] = NULL;
 		host_to_node_hashtbl[i] = NULL;
 	}
+	xfree(node_index_tbl);
+	node_index_cnt = 0;
+	node_index_size = 0;
+	node_index_hash = 0;
 	nodehash_initialized = false;
 }
 
@@ -1625,6 +1636,30 @@ static void _push_to_hashtbls(char *alias, char *hostname,
 	if (addr)
 		memcpy(&new->addr, addr, sizeof(slurm_addr_t));
 
+	/* Front end nodes are never message forwarding targets */
+	if (front_end) {
+		new->index = -1;
+	} else {
+		const char *c;
+
+		if (node_index_cnt >= node_index_size) {
+			node_index_size = MAX(node_index_size * 2, 64);
+			xrealloc(node_index_tbl,
+				 sizeof(names_ll_t *) * node_index_size);
+		}
+		new->index = node_index_cnt;
+		node_index_tbl[node_index_cnt++] = new;
+		/* FNV-1a over the names, '\0' separated */
+		if (node_index_cnt == 1)
+			node_index_hash = 2166136261U;
+		for (c = alias; ; c++) {
+			node_index_hash ^= (unsigned char) *c;
+			node_index_hash *= 16777619U;
+			if (!*c)
+				break;
+		}
+	}
+
 	/* Put on end of each list */
 	new->next_alias	= NULL;
 	if (node_to_host_hashtbl[alias_idx]) {
@@ -2217,6 +2252,68 @@ extern int slurm_conf_get_addr(const char *node_name, slurm_addr_t *address)
 	return SLURM_FAILURE;
 }
 
+/*
+ * slurm_conf_get_node_index - Return the position of NodeName in the
+ *	configured node table, or -1 if it is not found
+ */
+extern int slurm_conf_get_node_index(const char *node_name)
+{
+	int idx, index = -1;
+	names_ll_t *p;
+
+	slurm_conf_lock();
+	_init_slurmd_nodehash();
+
+	idx = _get_hash_idx(node_name);
+	p = node_to_host_hashtbl[idx];
+	while (p) {
+		if (xstrcmp(p->alias, node_name) == 0) {
+			index = p->index;
+			break;
+		}
+		p = p->next_alias;
+	}
+	slurm_conf_unlock();
+
+	return index;
+}
+
+/*
+ * slurm_conf_get_node_by_index - Return the NodeName at the given position
+ *	of the configured node table, or NULL if out of range
+ */
+extern char *slurm_conf_get_node_by_index(int index)
+{
+	char *node_name = NULL;
+
+	slurm_conf_lock();
+	_init_slurmd_nodehash();
+	if ((index >= 0) && (index < node_index_cnt))
+		node_name = xstrdup(node_index_tbl[index]->alias);
+	slurm_conf_unlock();
+
+	return node_name;
+}
+
+/*
+ * slurm_conf_get_node_table - Return the number of nodes in the configured
+ *	node table and a hash of their names in table order. Peers with the
+ *	same hash agree on every node's index.
+ */
+extern int slurm_conf_get_node_table(uint32_t *hash)
+{
+	int cnt;
+
+	slurm_conf_lock();
+	_init_slurmd_nodehash();
+	cnt = node_index_cnt;
+	if (hash)
+		*hash = node_index_hash;
+	slurm_conf_unlock();
+
+	return cnt;
+}
+
 /*
  * slurm_conf_get_cpus_bsct -
  * Return the cpus, boards, sockets, cores, and threads configured for a
@@ -452,6 +452,32 @@ extern char *slurm_conf_get_aliased_nodename(void);
  */
 extern uint16_t slurm_conf_get_port(const char *node_name);
 
+/*
+ * slurm_conf_get_node_index - Return the position of NodeName in the
+ *	configured node table, or -1 if it is not found
+ *
+ * NOTE: Caller must NOT be holding slurm_conf_lock().
+ */
+extern int slurm_conf_get_node_index(const char *node_name);
+
+/*
+ * slurm_conf_get_node_by_index - Return the NodeName at the given position
+ *	of the configured node table, or NULL if out of range
+ *
+ * NOTE: Call xfree() to release returned value's memory.
+ * NOTE: Caller must NOT be holding slurm_conf_lock().
+ */
+extern char *slurm_conf_get_node_by_index(int index);
+
+/*
+ * slurm_conf_get_node_table - Return the number of nodes in the configured
+ *	node table and, if hash is set, a hash of their names in table order.
+ *	Peers reporting the same hash agree on every node's index.
+ *
+ * NOTE: Caller must NOT be holding slurm_conf_lock().
+ */
+extern int slurm_conf_get_node_table(uint32_t *hash);
+
 /*
  * slurm_conf_get_addr - Return the slurm_addr_t for a given NodeName in
  *	the parameter "address".  The return code is SLURM_SUCCESS on success,
@@ -44,6 +44,7 @@
 /* GLOBAL INCLUDES */
 
 #include <ctype.h>
+#include <dlfcn.h>
 #include <errno.h>
 #include <pthread.h>
 #include <stdio.h>
@@ -54,6 +55,10 @@
 #include <time.h>
 #include <unistd.h>
 
+#if HAVE_LZ4
+#  include <lz4.h>
+#endif
+
 /* PROJECT INCLUDES */
 #include "src/common/assoc_mgr.h"
 #include "src/common/fd.h"
@@ -94,9 +99,49 @@ static slurm_protocol_config_t *proto_conf = &proto_conf_default;
 /* static slurm_ctl_conf_t slurmctld_conf; */
 static int message_timeout = -1;
 
+/*
+ * liblz4 is loaded on first use rather than linked, so that the many
+ * programs linking libslurm do not all pick up a new dependency. A node
+ * without the library simply does not advertise SLURM_MSG_ACCEPT_LZ4.
+ */
+#if HAVE_LZ4
+static pthread_once_t lz4_once = PTHREAD_ONCE_INIT;
+static bool lz4_avail = false;
+static int (*lz4_compress_bound)(int input_size);
+static int (*lz4_compress)(const char *src, char *dst, int src_size,
+			   int dst_capacity);
+static int (*lz4_decompress)(const char *src, char *dst, int compressed_size,
+			     int dst_capacity);
+#endif
+
+/* Reply compression counters, see slurm_get_msg_compress_stats() */
+static pthread_mutex_t compress_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t compress_msg_cnt = 0;
+static uint64_t compress_bytes_in = 0;
+static uint64_t compress_bytes_out = 0;
+
+/*
+ * See slurm_msg_envelope_create(). The data is never changed once packed,
+ * so senders use it without holding the lock. A send made after the
+ * credential reaches ENVELOPE_MAX_AGE packs the message on its own, just
+ * as slurm_send_node_msg() replaces a credential which has waited that long.
+ */
+#define ENVELOPE_MAX_AGE 60
+struct msg_envelope {
+	pthread_mutex_t lock;
+	bool packed;
+	time_t pack_time;
+	uint16_t msg_type;
+	uint16_t protocol_version;
+	char *data;		/* credential followed by the message body */
+	uint32_t auth_len;
+	uint32_t body_len;
+};
+
 /* STATIC FUNCTIONS */
 static char *_global_auth_key(void);
 static void  _remap_slurmctld_errno(void);
+static int   _uncompress_msg_body(header_t *header, Buf buffer);
 static int   _unpack_msg_uid(Buf buffer);
 static bool  _is_port_ok(int, uint16_t);
 
@@ -3197,6 +3242,12 @@ extern int slurm_unpack_received_msg(slurm_msg_t *msg, int fd, Buf buffer)
 		goto total_return;
 	}
 
+	if (_uncompress_msg_body(&header, buffer) != SLURM_SUCCESS) {
+		(void) g_slurm_auth_destroy(auth_cred);
+		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
+		goto total_return;
+	}
+
 	/*
 	 * Unpack message body
 	 */
@@ -3469,6 +3520,13 @@ List slurm_receive_msgs(int fd, int steps, int timeout)
 		goto total_return;
 	}
 
+	if (_uncompress_msg_body(&header, buffer) != SLURM_SUCCESS) {
+		(void) g_slurm_auth_destroy(auth_cred);
+		free_buf(buffer);
+		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
+		goto total_return;
+	}
+
 	/*
 	 * Unpack message body
 	 */
@@ -3669,6 +3727,8 @@ int slurm_receive_msg_and_forward(int fd, slurm_addr_t *orig_addr,
 		if (msg->forward_struct->timeout <= 0)
 			msg->forward_struct->timeout = message_timeout;
 		msg->forward_struct->fwd_cnt = header.forward.cnt;
+		msg->forward_struct->node_table_ok =
+			(header.flags & SLURM_MSG_NODE_TABLE_OK);
 
 		debug3("forwarding messages to %u nodes with timeout of %d",
 		       msg->forward_struct->fwd_cnt,
@@ -3703,6 +3763,13 @@ int slurm_receive_msg_and_forward(int fd, slurm_addr_t *orig_addr,
 		goto total_return;
 	}
 
+	if (_uncompress_msg_body(&header, buffer) != SLURM_SUCCESS) {
+		(void) g_slurm_auth_destroy(auth_cred);
+		free_buf(buffer);
+		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
+		goto total_return;
+	}
+
 	/*
 	 * Unpack message body
 	 */
@@ -3749,6 +3816,193 @@ total_return:
  * send message functions
 \**********************************************************************/
 
+#if HAVE_LZ4
+/* Load liblz4, run once through lz4_once */
+static void _lz4_load_once(void)
+{
+	void *handle;
+
+	if (!(handle = dlopen("liblz4.so.1", RTLD_NOW | RTLD_LOCAL)) &&
+	    !(handle = dlopen("liblz4.so",   RTLD_NOW | RTLD_LOCAL))) {
+		debug("%s: liblz4 not available, RPC replies will not be "
+		      "compressed: %s", __func__, dlerror());
+	} else if (!(lz4_compress_bound =
+		     dlsym(handle, "LZ4_compressBound")) ||
+		   !(lz4_compress = dlsym(handle, "LZ4_compress_default")) ||
+		   !(lz4_decompress = dlsym(handle, "LZ4_decompress_safe"))) {
+		error("%s: liblz4 lacks a required symbol: %s",
+		      __func__, dlerror());
+		dlclose(handle);
+	} else
+		lz4_avail = true;
+}
+
+/*
+ * Load liblz4 if not already done. RET true if it is usable
+ * Called for every message sent, after the first call pthread_once() is
+ * only a flag test.
+ */
+static bool _lz4_load(void)
+{
+	pthread_once(&lz4_once, _lz4_load_once);
+	return lz4_avail;
+}
+#endif
+
+/*
+ * Compress the pre-packed body of a reply if the peer asked for compressed
+ * replies (SLURM_MSG_ACCEPT_LZ4 in the request, which the reply inherits)
+ * and the body is large enough to be worth it. The compressed body is the
+ * uncompressed length followed by a single lz4 block.
+ * OUT body - set to an xmalloc()ed compressed body, must be xfreed
+ * OUT body_len - length of body
+ * RET true if the body was compressed
+ */
+static bool _compress_msg_body(slurm_msg_t *msg, char **body,
+			       uint32_t *body_len)
+{
+#if HAVE_LZ4
+	uint32_t bound, nlen;
+	int out_len;
+	char *out;
+
+	/*
+	 * Only the peer's flag is checked here. Two kinds of reply never
+	 * carry it. Forwarded requests have SLURM_MSG_ACCEPT_LZ4 cleared in
+	 * forward.c, because their replies are small return codes gathered
+	 * by the forwarding node. slurmdbd traffic uses persistent
+	 * connections that never pass through slurm_send_node_msg().
+	 */
+	if (!(msg->flags & SLURM_MSG_ACCEPT_LZ4) ||
+	    (msg->protocol_version < SLURM_17_11_PROTOCOL_VERSION) ||
+	    (msg->data_size < SLURM_MSG_COMPRESS_MIN_SIZE) ||
+	    (msg->data_size > LZ4_MAX_INPUT_SIZE) || !_lz4_load())
+		return false;
+
+	bound = (*lz4_compress_bound)(msg->data_size);
+	out = xmalloc_nz(sizeof(uint32_t) + bound);
+	out_len = (*lz4_compress)(msg->data, out + sizeof(uint32_t),
+				  msg->data_size, bound);
+	/* Not worth it for incompressible data */
+	if ((out_len <= 0) ||
+	    ((out_len + sizeof(uint32_t)) >= msg->data_size)) {
+		xfree(out);
+		return false;
+	}
+
+	nlen = htonl(msg->data_size);
+	memcpy(out, &nlen, sizeof(nlen));
+	*body = out;
+	*body_len = out_len + sizeof(uint32_t);
+
+	slurm_mutex_lock(&compress_stats_lock);
+	compress_msg_cnt++;
+	compress_bytes_in += msg->data_size;
+	compress_bytes_out += *body_len;
+	slurm_mutex_unlock(&compress_stats_lock);
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+/*
+ * If the body of a received message is compressed, replace the contents of
+ * buffer with the uncompressed body and clear the flag in the header.
+ * RET SLURM_SUCCESS or SLURM_ERROR
+ */
+static int _uncompress_msg_body(header_t *header, Buf buffer)
+{
+#if HAVE_LZ4
+	uint32_t orig_len;
+	int out_len;
+	char *out;
+#endif
+
+	if (!(header->flags & SLURM_MSG_COMPRESS_LZ4))
+		return SLURM_SUCCESS;
+
+#if HAVE_LZ4
+	if (!_lz4_load()) {
+		error("%s: received lz4 compressed %s message, but liblz4 is not available",
+		      __func__, rpc_num2string(header->msg_type));
+		return SLURM_ERROR;
+	}
+	if ((header->body_length > remaining_buf(buffer)) ||
+	    (header->body_length <= sizeof(uint32_t)) ||
+	    (unpack32(&orig_len, buffer) != SLURM_SUCCESS) ||
+	    (orig_len > MAX_BUF_SIZE) || !orig_len) {
+		error("%s: invalid compressed %s message",
+		      __func__, rpc_num2string(header->msg_type));
+		return SLURM_ERROR;
+	}
+
+	out = xmalloc_nz(orig_len);
+	out_len = (*lz4_decompress)(&buffer->head[buffer->processed], out,
+				    header->body_length - sizeof(uint32_t),
+				    orig_len);
+	if (out_len != orig_len) {
+		error("%s: lz4 decompression of %s message failed",
+		      __func__, rpc_num2string(header->msg_type));
+		xfree(out);
+		return SLURM_ERROR;
+	}
+
+	xfree(buffer->head);
+	buffer->head = out;
+	buffer->size = orig_len;
+	buffer->processed = 0;
+	header->body_length = orig_len;
+	header->flags &= ~SLURM_MSG_COMPRESS_LZ4;
+	return SLURM_SUCCESS;
+#else
+	error("%s: received lz4 compressed %s message without lz4 support",
+	      __func__, rpc_num2string(header->msg_type));
+	return SLURM_ERROR;
+#endif
+}
+
+/*
+ * slurm_get_msg_compress_stats - report reply compression counters
+ * OUT msg_cnt - number of replies sent compressed
+ * OUT bytes_in - uncompressed size of those replies
+ * OUT bytes_out - size actually sent
+ * IN reset - clear the counters after reading them
+ */
+extern void slurm_get_msg_compress_stats(uint64_t *msg_cnt,
+					 uint64_t *bytes_in,
+					 uint64_t *bytes_out, bool reset)
+{
+	slurm_mutex_lock(&compress_stats_lock);
+	*msg_cnt = compress_msg_cnt;
+	*bytes_in = compress_bytes_in;
+	*bytes_out = compress_bytes_out;
+	if (reset) {
+		compress_msg_cnt = 0;
+		compress_bytes_in = 0;
+		compress_bytes_out = 0;
+	}
+	slurm_mutex_unlock(&compress_stats_lock);
+}
+
+/*
+ *  Set the body length in hdr and repack it at the start of buffer, for a
+ *  body of body_len bytes which is sent separately from buffer
+ */
+static void
+_pack_header_len(header_t *hdr, Buf buffer, uint32_t body_len)
+{
+	unsigned int tmplen;
+
+	update_header(hdr, body_len);
+
+	tmplen = get_buf_offset(buffer);
+	set_buf_offset(buffer, 0);
+	pack_header(hdr, buffer);
+	set_buf_offset(buffer, tmplen);
+}
+
 /*
  *  Do the wonderful stuff that needs be done to pack msg
  *  and hdr into buffer
@@ -3763,13 +4017,92 @@ _pack_msg(slurm_msg_t *msg, header_t *hdr, Buf buffer)
 	msglen = get_buf_offset(buffer) - tmplen;
 
 	/* update header with correct cred and msg lengths */
-	update_header(hdr, msglen);
+	_pack_header_len(hdr, buffer, msglen);
+}
 
-	/* repack updated header */
-	tmplen = get_buf_offset(buffer);
-	set_buf_offset(buffer, 0);
-	pack_header(hdr, buffer);
-	set_buf_offset(buffer, tmplen);
+/*
+ *  Create the credential for a message sent by this process
+ */
+static void *_auth_cred_create(slurm_msg_t *msg)
+{
+	void *auth_cred;
+
+	if (msg->flags & SLURM_GLOBAL_AUTH_KEY) {
+		auth_cred = g_slurm_auth_create(_global_auth_key());
+	} else {
+		char *auth_info = slurm_get_auth_info();
+		auth_cred = g_slurm_auth_create(auth_info);
+		xfree(auth_info);
+	}
+
+	return auth_cred;
+}
+
+extern msg_envelope_t *slurm_msg_envelope_create(void)
+{
+	msg_envelope_t *envelope = xmalloc(sizeof(msg_envelope_t));
+
+	slurm_mutex_init(&envelope->lock);
+	return envelope;
+}
+
+extern void slurm_msg_envelope_destroy(msg_envelope_t *envelope)
+{
+	if (!envelope)
+		return;
+	slurm_mutex_destroy(&envelope->lock);
+	xfree(envelope->data);
+	xfree(envelope);
+}
+
+/*
+ *  Return the credential and body of msg from its envelope, packing them
+ *  on first use, or NULL if msg must be packed on its own
+ */
+static char *_envelope_get(slurm_msg_t *msg, uint32_t *auth_len,
+			   uint32_t *body_len)
+{
+	msg_envelope_t *envelope = msg->envelope;
+	char *data = NULL;
+	void *auth_cred;
+	Buf buffer;
+
+	if (pack_msg_is_buffer(msg->msg_type))
+		return NULL;
+
+	slurm_mutex_lock(&envelope->lock);
+	if (!envelope->packed) {
+		/* One attempt only, later messages pack their own on error */
+		envelope->packed = true;
+		envelope->msg_type = msg->msg_type;
+		envelope->protocol_version = msg->protocol_version;
+		envelope->pack_time = time(NULL);
+		buffer = init_buf(BUF_SIZE);
+		if ((auth_cred = _auth_cred_create(msg)) &&
+		    !g_slurm_auth_pack(auth_cred, buffer)) {
+			envelope->auth_len = get_buf_offset(buffer);
+			pack_msg(msg, buffer);
+			envelope->body_len = get_buf_offset(buffer) -
+					     envelope->auth_len;
+			envelope->data = xfer_buf_data(buffer);
+			debug3("%s: packed %u byte body of msg_type=%u",
+			       __func__, envelope->body_len, msg->msg_type);
+		} else
+			free_buf(buffer);
+		if (auth_cred)
+			(void) g_slurm_auth_destroy(auth_cred);
+	}
+	if (envelope->data &&
+	    (envelope->msg_type == msg->msg_type) &&
+	    (envelope->protocol_version == msg->protocol_version) &&
+	    (difftime(time(NULL), envelope->pack_time) < ENVELOPE_MAX_AGE)) {
+		data = envelope->data;
+		*auth_len = envelope->auth_len;
+		*body_len = envelope->body_len;
+	}
+	slurm_mutex_unlock(&envelope->lock);
+
+	return data;
 }
 
 /*
@@ -3781,8 +4114,15 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 	header_t header;
 	Buf      buffer;
 	int      rc;
-	void *   auth_cred;
+	struct iovec iov[2];
+	int      iovcnt = 1;
+	void *   auth_cred = NULL;
 	time_t   start_time = time(NULL);
+	char *   zbody = NULL;
+	uint32_t zbody_len = 0;
+	char *   env_data = NULL;
+	uint32_t env_auth_len = 0, env_body_len = 0;
+	bool     node_table_ok;
 
 	if (msg->conn) {
 		persist_msg_t persist_msg;
@@ -3815,6 +4155,13 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 		return rc;
 	}
 
+	/*
+	 * A message sharing an envelope is sent with the credential and
+	 * body packed by the first message to use it
+	 */
+	if (msg->envelope)
+		env_data = _envelope_get(msg, &env_auth_len, &env_body_len);
+
 	/*
 	 * Initialize header with Auth credential and message type.
 	 * We get the credential now rather than later so the work can
@@ -3822,13 +4169,8 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 	 * but we may need to generate the credential again later if we
 	 * wait too long for the incoming message.
 	 */
-	if (msg->flags & SLURM_GLOBAL_AUTH_KEY) {
-		auth_cred = g_slurm_auth_create(_global_auth_key());
-	} else {
-		char *auth_info = slurm_get_auth_info();
-		auth_cred = g_slurm_auth_create(auth_info);
-		xfree(auth_info);
-	}
+	if (!env_data)
+		auth_cred = _auth_cred_create(msg);
 
 	if (msg->forward.init != FORWARD_INIT) {
 		forward_init(&msg->forward, NULL);
@@ -3838,48 +4180,85 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 	if (!msg->forward.tree_width)
 		msg->forward.tree_width = slurm_get_tree_width();
 
+	/* Only a sender which gave us node indexes gets them back */
+	node_table_ok = (msg->forward_struct &&
+			 msg->forward_struct->node_table_ok);
 	forward_wait(msg);
 
-	if (difftime(time(NULL), start_time) >= 60) {
+	if (!env_data && (difftime(time(NULL), start_time) >= 60)) {
 		(void) g_slurm_auth_destroy(auth_cred);
-		if (msg->flags & SLURM_GLOBAL_AUTH_KEY) {
-			auth_cred = g_slurm_auth_create(_global_auth_key());
-		} else {
-			char *auth_info = slurm_get_auth_info();
-			auth_cred = g_slurm_auth_create(auth_info);
-			xfree(auth_info);
-		}
+		auth_cred = _auth_cred_create(msg);
 	}
-	if (auth_cred == NULL) {
+	if (!env_data && (auth_cred == NULL)) {
 		error("authentication: %s",
 		      g_slurm_auth_errstr(g_slurm_auth_errno(NULL)) );
 		slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
 	}
 
 	init_header(&header, msg, msg->flags);
+	header.flags &= ~SLURM_MSG_NODE_TABLE_OK;
+	if (node_table_ok)
+		header.flags |= SLURM_MSG_NODE_TABLE_OK;
+	/* Advertise whether we can take compressed replies */
+	header.flags &= ~(SLURM_MSG_ACCEPT_LZ4 | SLURM_MSG_COMPRESS_LZ4);
+#if HAVE_LZ4
+	if (_lz4_load())
+		header.flags |= SLURM_MSG_ACCEPT_LZ4;
+#endif
 
 	/*
 	 * Pack header into buffer for transmission
 	 */
-	buffer = init_buf(BUF_SIZE);
+	buffer = init_cached_buf();
 	pack_header(&header, buffer);
 
 	/*
-	 * Pack auth credential
+	 * Pack auth credential, unless it is already in the envelope
 	 */
-	rc = g_slurm_auth_pack(auth_cred, buffer);
-	(void) g_slurm_auth_destroy(auth_cred);
+	if (env_data)
+		rc = SLURM_SUCCESS;
+	else {
+		rc = g_slurm_auth_pack(auth_cred, buffer);
+		(void) g_slurm_auth_destroy(auth_cred);
+	}
 	if (rc) {
 		error("authentication: %s",
 		      g_slurm_auth_errstr(g_slurm_auth_errno(auth_cred)));
-		free_buf(buffer);
+		free_cached_buf(buffer);
 		slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
 	}
 
-	/*
-	 * Pack message into buffer
-	 */
-	_pack_msg(msg, &header, buffer);
+	iov[0].iov_base = get_buf_data(buffer);
+	if (env_data) {
+		/* The credential travels with the body in the envelope */
+		_pack_header_len(&header, buffer, env_body_len);
+		iov[1].iov_base = env_data;
+		iov[1].iov_len = env_auth_len + env_body_len;
+		iovcnt = 2;
+	} else if (pack_msg_is_buffer(msg->msg_type)) {
+		/*
+		 * The body was already packed by the caller (job, node and
+		 * similar dumps), send it from where it is rather than
+		 * copying it behind the header and credential
+		 */
+		if (_compress_msg_body(msg, &zbody, &zbody_len)) {
+			header.flags |= SLURM_MSG_COMPRESS_LZ4;
+			_pack_header_len(&header, buffer, zbody_len);
+			iov[1].iov_base = zbody;
+			iov[1].iov_len = zbody_len;
+		} else {
+			_pack_header_len(&header, buffer, msg->data_size);
+			iov[1].iov_base = msg->data;
+			iov[1].iov_len = msg->data_size;
+		}
+		iovcnt = 2;
+	} else {
+		/*
+		 * Pack message into buffer
+		 */
+		_pack_msg(msg, &header, buffer);
+	}
+	iov[0].iov_len = get_buf_offset(buffer);
 
 #if	_DEBUG
 	_print_data (get_buf_data(buffer),get_buf_offset(buffer));
@@ -3887,9 +4266,9 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 	/*
 	 * Send message
 	 */
-	rc = slurm_msg_sendto( fd, get_buf_data(buffer),
-			       get_buf_offset(buffer),
-			       SLURM_PROTOCOL_NO_SEND_RECV_FLAGS );
+	rc = slurm_msg_sendv_timeout(fd, iov, iovcnt,
+				     SLURM_PROTOCOL_NO_SEND_RECV_FLAGS,
+				     (slurm_get_msg_timeout() * 1000));
 
 	if ((rc < 0) && (errno == ENOTCONN)) {
 		debug3("slurm_msg_sendto: peer has disappeared for msg_type=%u",
@@ -3912,7 +4291,8 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 			      msg->msg_type);
 	}
 
-	free_buf(buffer);
+	free_cached_buf(buffer);
+	xfree(zbody);
 	return rc;
 }
 
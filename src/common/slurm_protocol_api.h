@@ -1040,10 +1040,33 @@ List slurm_receive_msgs(int fd, int steps, int timeout);
 int slurm_receive_msg_and_forward(int fd, slurm_addr_t *orig_addr,
 				  slurm_msg_t *resp, int timeout);
 
+/*
+ * slurm_get_msg_compress_stats - report reply compression counters
+ * OUT msg_cnt - number of replies sent compressed
+ * OUT bytes_in - uncompressed size of those replies
+ * OUT bytes_out - size actually sent
+ * IN reset - clear the counters after reading them
+ */
+extern void slurm_get_msg_compress_stats(uint64_t *msg_cnt,
+					 uint64_t *bytes_in,
+					 uint64_t *bytes_out, bool reset);
+
 /**********************************************************************\
  * send message functions
 \**********************************************************************/
 
+/*
+ * slurm_msg_envelope_create - create an envelope which lets every message
+ *	of a fan-out share one credential and packed body. Set it as the
+ *	envelope of each slurm_msg_t sent; the first send packs it. Leave
+ *	it unset when resending to nodes which may have received the
+ *	message, a credential can only be decoded once by each node.
+ * RET envelope, release with slurm_msg_envelope_destroy() once every
+ *	message using it has been sent
+ */
+extern msg_envelope_t *slurm_msg_envelope_create(void);
+extern void slurm_msg_envelope_destroy(msg_envelope_t *envelope);
+
 /* sends a message to an arbitrary node
  *
  * IN open_fd		- file descriptor to send msg on
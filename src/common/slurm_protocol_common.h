@@ -75,11 +75,16 @@
  * done here with them since we have to support old version of archive
  * files since they don't update once they are created.
  */
+/*
+ * 17.11 plus message headers carrying forward lists as node indexes and
+ * ret lists summarized by result, with ping replies as node bitmaps
+ */
+#define SLURM_17_11_FWD_PROTOCOL_VERSION ((32 << 8) | 1)
 #define SLURM_17_11_PROTOCOL_VERSION ((32 << 8) | 0)
 #define SLURM_17_02_PROTOCOL_VERSION ((31 << 8) | 0)
 #define SLURM_16_05_PROTOCOL_VERSION ((30 << 8) | 0)
 
-#define SLURM_PROTOCOL_VERSION SLURM_17_11_PROTOCOL_VERSION
+#define SLURM_PROTOCOL_VERSION SLURM_17_11_FWD_PROTOCOL_VERSION
 #define SLURM_ONE_BACK_PROTOCOL_VERSION SLURM_17_02_PROTOCOL_VERSION
 #define SLURM_MIN_PROTOCOL_VERSION SLURM_16_05_PROTOCOL_VERSION
 
@@ -106,6 +111,15 @@
 #define SLURM_GLOBAL_AUTH_KEY   0x0001
 #define SLURMDBD_CONNECTION     0x0002
 #define SLURM_MSG_KEEP_BUFFER   0x0004
+#define SLURM_MSG_ACCEPT_LZ4    0x0008	/* sender takes lz4 compressed replies */
+#define SLURM_MSG_COMPRESS_LZ4  0x0010	/* message body is lz4 compressed */
+#define SLURM_MSG_FORWARD_INDEX 0x0020	/* forward list packed as node indexes */
+#define SLURM_MSG_RET_SUMMARY   0x0040	/* ret_list packed grouped by result */
+#define SLURM_MSG_NODE_TABLE_OK 0x0080	/* never sent, peer indexes nodes as we
+					 * do (it sent us node indexes) */
+
+/* Replies with bodies smaller than this are never compressed */
+#define SLURM_MSG_COMPRESS_MIN_SIZE	(64 * 1024)
 
 #include "src/common/slurm_protocol_socket_common.h"
 
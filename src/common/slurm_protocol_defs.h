@@ -408,6 +408,9 @@ typedef struct forward {
 	uint16_t   init;	/* tell me it has been set (FORWARD_INIT) */
 	char      *nodelist;	/* ranged string of who to forward the
 				 * message to */
+	bitstr_t  *nodes;	/* who to forward the message to, as indexes
+				 * into the configured node table. Used in
+				 * place of nodelist when set */
 	uint32_t   timeout;	/* original timeout increments */
 	uint16_t   tree_width;  /* what the treewidth should be */
 } forward_t;
@@ -434,6 +437,8 @@ typedef struct forward_struct {
 	pthread_cond_t notify;
 	List ret_list;
 	int timeout;
+	bool node_table_ok;	/* sender sent node indexes that matched our
+				 * node table, so replies may use them too */
 } forward_struct_t;
 
 typedef struct forward_message {
@@ -442,6 +447,12 @@ typedef struct forward_message {
 	int timeout;
 } forward_msg_t;
 
+/*
+ * Credential and body of a message packed once and sent unchanged to every
+ * node of a fan-out, see slurm_msg_envelope_create()
+ */
+typedef struct msg_envelope msg_envelope_t;
+
 typedef struct slurm_protocol_config {
 	slurm_addr_t primary_controller;
 	slurm_addr_t secondary_controller;
@@ -476,6 +487,8 @@ typedef struct slurm_msg {
 	forward_struct_t *forward_struct;
 	slurm_addr_t orig_addr;
 	List ret_list;
+	msg_envelope_t *envelope; /* DON'T PACK OR FREE! if set, send the
+				   * shared credential and body from here */
 } slurm_msg_t;
 
 typedef struct ret_data_info {
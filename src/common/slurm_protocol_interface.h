@@ -48,6 +48,7 @@
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "src/common/macros.h"
@@ -107,6 +108,22 @@ extern ssize_t slurm_msg_sendto_timeout(int open_fd,
 					uint32_t flags,
 					int timeout);
 
+/* slurm_msg_sendv_timeout
+ * Send a message made up of several separate buffers over the given
+ * connection with a single length prefix, without copying them together
+ * IN open_fd - an open file descriptor
+ * IN iov - buffers to transmit, in order
+ * IN iovcnt - number of elements in iov
+ * IN flags - communication specific flags
+ * IN timeout - maximum time to wait for a message in milliseconds
+ * RET number of bytes written (excluding the length prefix)
+ */
+extern ssize_t slurm_msg_sendv_timeout(int open_fd,
+				       struct iovec *iov,
+				       int iovcnt,
+				       uint32_t flags,
+				       int timeout);
+
 /********************/
 /* stream functions */
 /********************/
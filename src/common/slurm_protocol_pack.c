@@ -68,18 +68,6 @@
 #include "src/common/xassert.h"
 
 
-#define _pack_job_info_msg(msg,buf)		_pack_buffer_msg(msg,buf)
-#define _pack_job_step_info_msg(msg,buf)	_pack_buffer_msg(msg,buf)
-#define _pack_block_info_resp_msg(msg,buf)	_pack_buffer_msg(msg,buf)
-#define _pack_burst_buffer_info_resp_msg(msg,buf) _pack_buffer_msg(msg,buf)
-#define _pack_front_end_info_msg(msg,buf)	_pack_buffer_msg(msg,buf)
-#define _pack_node_info_msg(msg,buf)		_pack_buffer_msg(msg,buf)
-#define _pack_partition_info_msg(msg,buf)	_pack_buffer_msg(msg,buf)
-#define _pack_stats_response_msg(msg,buf)	_pack_buffer_msg(msg,buf)
-#define _pack_reserve_info_msg(msg,buf)		_pack_buffer_msg(msg,buf)
-#define _pack_layout_info_msg(msg,buf)		_pack_buffer_msg(msg,buf)
-#define _pack_assoc_mgr_info_msg(msg,buf)      _pack_buffer_msg(msg,buf)
-
 static void _pack_assoc_shares_object(void *in, uint32_t tres_cnt, Buf buffer,
 				      uint16_t protocol_version);
 static int _unpack_assoc_shares_object(void **object, uint32_t tres_cnt,
@@ -472,6 +460,10 @@ static void _pack_ret_list(List ret_list, uint16_t size_val, Buf buffer,
 			   uint16_t protocol_version);
 static int _unpack_ret_list(List *ret_list, uint16_t size_val, Buf buffer,
 			    uint16_t protocol_version);
+static uint16_t _pack_ret_summary(List ret_list, Buf buffer,
+				  uint16_t protocol_version, bool index_ok);
+static int _unpack_ret_summary(List *ret_list, uint16_t group_cnt, Buf buffer,
+			       uint16_t protocol_version);
 
 static void _pack_job_id_request_msg(job_id_request_msg_t * msg, Buf buffer,
 				     uint16_t protocol_version);
@@ -701,7 +693,6 @@ static void _pack_license_info_request_msg(license_info_request_msg_t *msg,
 static int _unpack_license_info_request_msg(license_info_request_msg_t **msg,
 					    Buf buffer,
 					    uint16_t protocol_version);
-static inline void _pack_license_info_msg(slurm_msg_t *msg, Buf buffer);
 static int _unpack_license_info_msg(license_info_msg_t **msg,
 				    Buf buffer,
 				    uint16_t protocol_version);
@@ -762,6 +753,72 @@ static int _unpack_buf_list_msg(ctld_list_msg_t **msg, Buf buffer,
 
 static void _priority_factors_resp_list_del(void *x);
 
+/*
+ * Pack a forward list of node table indexes as runs of consecutive nodes,
+ * preceded by the node table hash so the receiver can check that it indexes
+ * nodes the same way.
+ */
+static void _pack_forward_nodes(bitstr_t *nodes, Buf buffer)
+{
+	uint32_t hash = 0, run_cnt = 0, run_offset, tmp_offset;
+	int i, first, last, run_start;
+
+	(void) slurm_conf_get_node_table(&hash);
+	pack32(hash, buffer);
+	pack32((uint32_t) bit_size(nodes), buffer);
+
+	run_offset = get_buf_offset(buffer);
+	pack32(run_cnt, buffer);
+	first = bit_ffs(nodes);
+	last = bit_fls(nodes);
+	for (i = first; (first >= 0) && (i <= last); i++) {
+		if (!bit_test(nodes, i))
+			continue;
+		run_start = i;
+		while ((i < last) && bit_test(nodes, i + 1))
+			i++;
+		pack32((uint32_t) run_start, buffer);
+		pack32((uint32_t) (i - run_start + 1), buffer);
+		run_cnt++;
+	}
+
+	tmp_offset = get_buf_offset(buffer);
+	set_buf_offset(buffer, run_offset);
+	pack32(run_cnt, buffer);
+	set_buf_offset(buffer, tmp_offset);
+}
+
+static int _unpack_forward_nodes(bitstr_t **nodes, Buf buffer)
+{
+	uint32_t hash, local_hash = 0, node_cnt, run_cnt, start, len, i;
+
+	safe_unpack32(&hash, buffer);
+	safe_unpack32(&node_cnt, buffer);
+	if ((node_cnt != slurm_conf_get_node_table(&local_hash)) ||
+	    (hash != local_hash)) {
+		error("%s: forwarded node list does not match the local "
+		      "node table, check that slurm.conf is the same on all "
+		      "nodes", __func__);
+		goto unpack_error;
+	}
+
+	*nodes = bit_alloc(node_cnt);
+	safe_unpack32(&run_cnt, buffer);
+	for (i = 0; i < run_cnt; i++) {
+		safe_unpack32(&start, buffer);
+		safe_unpack32(&len, buffer);
+		if (!len || (start >= node_cnt) || (len > node_cnt - start))
+			goto unpack_error;
+		bit_nset(*nodes, start, start + len - 1);
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	FREE_NULL_BITMAP(*nodes);
+	return SLURM_ERROR;
+}
+
 /* pack_header
  * packs a slurm protocol header that precedes every slurm message
  * IN header - the header structure to pack
@@ -771,6 +828,14 @@ static void _priority_factors_resp_list_del(void *x);
 void
 pack_header(header_t * header, Buf buffer)
 {
+	uint16_t flags = header->flags &
+		~(SLURM_MSG_FORWARD_INDEX | SLURM_MSG_RET_SUMMARY |
+		  SLURM_MSG_NODE_TABLE_OK);
+	char *nodelist = header->forward.nodelist;
+	uint32_t ret_offset, tmp_offset;
+	uint16_t group_cnt;
+	hostlist_t hl;
+
 	/* The DBD always unpacks the message type first.  DO NOT UNPACK THIS ON
 	 * THE UNPACK SIDE.
 	 */
@@ -779,25 +844,59 @@ pack_header(header_t * header, Buf buffer)
 
 	pack16((uint16_t)header->version, buffer);
 
+	/* Older peers only understand a forward list of names */
+	if ((header->forward.cnt > 0) && header->forward.nodes) {
+		if (header->version >= SLURM_17_11_FWD_PROTOCOL_VERSION) {
+			flags |= SLURM_MSG_FORWARD_INDEX;
+		} else {
+			hl = forward_bitmap2hostlist(header->forward.nodes);
+			nodelist = hostlist_ranged_string_xmalloc(hl);
+			hostlist_destroy(hl);
+		}
+	}
+	if ((header->ret_cnt > 0) &&
+	    (header->version >= SLURM_17_11_FWD_PROTOCOL_VERSION))
+		flags |= SLURM_MSG_RET_SUMMARY;
+
 	if (header->version >= SLURM_MIN_PROTOCOL_VERSION) {
-		pack16((uint16_t)header->flags, buffer);
+		pack16(flags, buffer);
 		pack16((uint16_t)header->msg_index, buffer);
 		pack16((uint16_t)header->msg_type, buffer);
 		pack32((uint32_t)header->body_length, buffer);
 		pack16((uint16_t)header->forward.cnt, buffer);
 		if (header->forward.cnt > 0) {
-			packstr(header->forward.nodelist, buffer);
+			if (flags & SLURM_MSG_FORWARD_INDEX)
+				_pack_forward_nodes(header->forward.nodes,
+						    buffer);
+			else
+				packstr(nodelist, buffer);
 			pack32((uint32_t)header->forward.timeout, buffer);
 			pack16(header->forward.tree_width, buffer);
 		}
-		pack16((uint16_t)header->ret_cnt, buffer);
-		if (header->ret_cnt > 0) {
-			_pack_ret_list(header->ret_list,
-				       header->ret_cnt, buffer,
-				       header->version);
+		if (flags & SLURM_MSG_RET_SUMMARY) {
+			/* Count of groups is only known after packing them */
+			ret_offset = get_buf_offset(buffer);
+			pack16(0, buffer);
+			group_cnt = _pack_ret_summary(
+				header->ret_list, buffer, header->version,
+				(header->flags & SLURM_MSG_NODE_TABLE_OK));
+			tmp_offset = get_buf_offset(buffer);
+			set_buf_offset(buffer, ret_offset);
+			pack16(group_cnt, buffer);
+			set_buf_offset(buffer, tmp_offset);
+		} else {
+			pack16((uint16_t)header->ret_cnt, buffer);
+			if (header->ret_cnt > 0) {
+				_pack_ret_list(header->ret_list,
+					       header->ret_cnt, buffer,
+					       header->version);
+			}
 		}
 		slurm_pack_slurm_addr(&header->orig_addr, buffer);
 	}
+
+	if (nodelist != header->forward.nodelist)
+		xfree(nodelist);
 }
 
 /* unpack_header
@@ -819,19 +918,50 @@ unpack_header(header_t * header, Buf buffer)
 
 	if (header->version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpack16(&header->flags, buffer);
+		header->flags &= ~SLURM_MSG_NODE_TABLE_OK;
 		safe_unpack16(&header->msg_index, buffer);
 		safe_unpack16(&header->msg_type, buffer);
 		safe_unpack32(&header->body_length, buffer);
 		safe_unpack16(&header->forward.cnt, buffer);
 		if (header->forward.cnt > 0) {
-			safe_unpackstr_xmalloc(&header->forward.nodelist,
-					       &uint32_tmp, buffer);
+			if ((header->flags & SLURM_MSG_FORWARD_INDEX) &&
+			    (header->version <
+			     SLURM_17_11_FWD_PROTOCOL_VERSION)) {
+				error("%s: node index forward list from "
+				      "protocol_version %hu", __func__,
+				      header->version);
+				goto unpack_error;
+			} else if (header->flags & SLURM_MSG_FORWARD_INDEX) {
+				if (_unpack_forward_nodes(
+					    &header->forward.nodes, buffer))
+					goto unpack_error;
+				header->flags &= ~SLURM_MSG_FORWARD_INDEX;
+				header->flags |= SLURM_MSG_NODE_TABLE_OK;
+			} else {
+				safe_unpackstr_xmalloc(
+					&header->forward.nodelist,
+					&uint32_tmp, buffer);
+			}
 			safe_unpack32(&header->forward.timeout, buffer);
 			safe_unpack16(&header->forward.tree_width, buffer);
 		}
 
 		safe_unpack16(&header->ret_cnt, buffer);
-		if (header->ret_cnt > 0) {
+		if ((header->flags & SLURM_MSG_RET_SUMMARY) &&
+		    (header->version < SLURM_17_11_FWD_PROTOCOL_VERSION)) {
+			error("%s: ret list summary from protocol_version %hu",
+			      __func__, header->version);
+			goto unpack_error;
+		}
+		if ((header->ret_cnt > 0) &&
+		    (header->flags & SLURM_MSG_RET_SUMMARY)) {
+			if (_unpack_ret_summary(&(header->ret_list),
+						header->ret_cnt, buffer,
+						header->version))
+				goto unpack_error;
+			header->ret_cnt = list_count(header->ret_list);
+			header->flags &= ~SLURM_MSG_RET_SUMMARY;
+		} else if (header->ret_cnt > 0) {
 			if (_unpack_ret_list(&(header->ret_list),
 					     header->ret_cnt, buffer,
 					     header->version))
@@ -856,6 +986,41 @@ unpack_error:
 }
 
 
+/*
+ * Message types whose body is packed by the sender (the job, node and
+ * similar dumps) and sent as is, see _pack_buffer_msg()
+ */
+static const uint16_t buffer_msg_types[] = {
+	RESPONSE_ASSOC_MGR_INFO,
+	RESPONSE_BLOCK_INFO,
+	RESPONSE_BURST_BUFFER_INFO,
+	RESPONSE_FRONT_END_INFO,
+	RESPONSE_JOB_INFO,
+	RESPONSE_JOB_STEP_INFO,
+	RESPONSE_LAYOUT_INFO,
+	RESPONSE_LICENSE_INFO,
+	RESPONSE_NODE_INFO,
+	RESPONSE_PARTITION_INFO,
+	RESPONSE_RESERVATION_INFO,
+	RESPONSE_STATS_INFO,
+};
+
+/* pack_msg_is_buffer
+ * IN msg_type - message type
+ * RET true if the body of such a message is already packed by the sender
+ *	(msg->data of msg->data_size bytes) and pack_msg() only copies it
+ */
+extern bool pack_msg_is_buffer(uint16_t msg_type)
+{
+	int i, cnt = sizeof(buffer_msg_types) / sizeof(buffer_msg_types[0]);
+
+	for (i = 0; i < cnt; i++) {
+		if (buffer_msg_types[i] == msg_type)
+			return true;
+	}
+	return false;
+}
+
 /* pack_msg
  * packs a generic slurm protocol message body
  * IN msg - the body structure to pack (note: includes message type)
@@ -866,6 +1031,11 @@ unpack_error:
 int
 pack_msg(slurm_msg_t const *msg, Buf buffer)
 {
+	if (pack_msg_is_buffer(msg->msg_type)) {
+		_pack_buffer_msg((slurm_msg_t *) msg, buffer);
+		return SLURM_SUCCESS;
+	}
+
 	switch (msg->msg_type) {
 	case REQUEST_NODE_INFO:
 		_pack_node_info_request_msg((node_info_request_msg_t *)
@@ -903,15 +1073,6 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 					 msg->data, buffer,
 					 msg->protocol_version);
 		break;
-	case RESPONSE_JOB_INFO:
-		_pack_job_info_msg((slurm_msg_t *) msg, buffer);
-		break;
-	case RESPONSE_PARTITION_INFO:
-		_pack_partition_info_msg((slurm_msg_t *) msg, buffer);
-		break;
-	case RESPONSE_NODE_INFO:
-		_pack_node_info_msg((slurm_msg_t *) msg, buffer);
-		break;
 	case MESSAGE_NODE_REGISTRATION_STATUS:
 		_pack_node_registration_status_msg(
 			(slurm_node_registration_status_msg_t *) msg->data,
@@ -1049,12 +1210,6 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 				      data, buffer,
 				      msg->protocol_version);
 		break;
-	case RESPONSE_RESERVATION_INFO:
-		_pack_reserve_info_msg((slurm_msg_t *) msg, buffer);
-		break;
-	case RESPONSE_LAYOUT_INFO:
-		_pack_layout_info_msg((slurm_msg_t *) msg, buffer);
-		break;
 	case REQUEST_DELETE_RESERVATION:
 	case RESPONSE_CREATE_RESERVATION:
 		_pack_resv_name_msg((reservation_name_msg_t *) msg->
@@ -1191,9 +1346,6 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 		break;
 	case RESPONSE_JOB_ATTACH:
 		break;
-	case RESPONSE_JOB_STEP_INFO:
-		_pack_job_step_info_msg((slurm_msg_t *) msg, buffer);
-		break;
 	case REQUEST_JOB_RESOURCE:
 		break;
 	case RESPONSE_JOB_RESOURCE:
@@ -1360,12 +1512,6 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 			(block_info_request_msg_t *) msg->data, buffer,
 			msg->protocol_version);
 		break;
-	case RESPONSE_BLOCK_INFO:
-		_pack_block_info_resp_msg((slurm_msg_t *) msg, buffer);
-		break;
-	case RESPONSE_BURST_BUFFER_INFO:
-		_pack_burst_buffer_info_resp_msg((slurm_msg_t *) msg, buffer);
-		break;
 	case REQUEST_FILE_BCAST:
 		_pack_file_bcast((file_bcast_msg_t *) msg->data, buffer,
 				 msg->protocol_version);
@@ -1441,9 +1587,6 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 			(slurmdb_federation_rec_t *)msg->data,
 			msg->protocol_version, buffer);
 		break;
-	case RESPONSE_FRONT_END_INFO:
-		_pack_front_end_info_msg((slurm_msg_t *) msg, buffer);
-		break;
 	case REQUEST_SPANK_ENVIRONMENT:
 		_pack_spank_env_request_msg(
 			(spank_env_request_msg_t *)msg->data, buffer,
@@ -1460,10 +1603,6 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 					buffer, msg->protocol_version);
 		break;
 
-	case RESPONSE_STATS_INFO:
-		_pack_stats_response_msg((slurm_msg_t *)msg, buffer);
-		break;
-
 	case REQUEST_FORWARD_DATA:
 		_pack_forward_data_msg((forward_data_msg_t *)msg->data,
 				       buffer, msg->protocol_version);
@@ -1479,9 +1618,6 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 						buffer,
 						msg->protocol_version);
 			break;
-	case RESPONSE_LICENSE_INFO:
-		_pack_license_info_msg((slurm_msg_t *) msg, buffer);
-		break;
 	case MESSAGE_COMPOSITE:
 	case RESPONSE_MESSAGE_COMPOSITE:
 		_pack_composite_msg((composite_msg_t *) msg->data, buffer,
@@ -1496,9 +1632,6 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 			(assoc_mgr_info_request_msg_t *)msg->data,
 			buffer, msg->protocol_version);
 		break;
-	case RESPONSE_ASSOC_MGR_INFO:
-		_pack_assoc_mgr_info_msg((slurm_msg_t *) msg, buffer);
-		break;
 	case REQUEST_NETWORK_CALLERID:
 		_pack_network_callerid_msg((network_callerid_msg_t *)
 						  msg->data, buffer,
@@ -4862,15 +4995,20 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+static const pack_field_t epilog_comp_fields[] = {
+	PACK_FIELD(32, epilog_complete_msg_t, job_id),
+	PACK_FIELD(32, epilog_complete_msg_t, return_code),
+	PACK_FIELD(STR, epilog_complete_msg_t, node_name),
+};
+
 static void
 _pack_epilog_comp_msg(epilog_complete_msg_t * msg, Buf buffer,
 		      uint16_t protocol_version)
 {
 	xassert(msg != NULL);
 	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
-		pack32((uint32_t)msg->job_id, buffer);
-		pack32((uint32_t)msg->return_code, buffer);
-		packstr(msg->node_name, buffer);
+		pack_fields(epilog_comp_fields,
+			    PACK_FIELD_CNT(epilog_comp_fields), msg, buffer);
 	}
 }
 
@@ -4879,17 +5017,15 @@ _unpack_epilog_comp_msg(epilog_complete_msg_t ** msg, Buf buffer,
 			uint16_t protocol_version)
 {
 	epilog_complete_msg_t *tmp_ptr;
-	uint32_t uint32_tmp;
 	/* alloc memory for structure */
 	xassert(msg);
 	tmp_ptr = xmalloc(sizeof(epilog_complete_msg_t));
 	*msg = tmp_ptr;
 
 	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
-		safe_unpack32(&(tmp_ptr->job_id), buffer);
-		safe_unpack32(&(tmp_ptr->return_code), buffer);
-		safe_unpackstr_xmalloc(&(tmp_ptr->node_name),
-				       &uint32_tmp, buffer);
+		safe_unpack_fields(epilog_comp_fields,
+				   PACK_FIELD_CNT(epilog_comp_fields),
+				   tmp_ptr, buffer);
 	}
 
 	return SLURM_SUCCESS;
@@ -10156,17 +10292,22 @@ unpack_error:
  * IN/OUT buffer - destination of the pack, contains pointers that are
  *			automatically updated
  */
+static const pack_field_t job_step_kill_fields[] = {
+	PACK_FIELD(STR, job_step_kill_msg_t, sjob_id),
+	PACK_FIELD(32, job_step_kill_msg_t, job_id),
+	PACK_FIELD(32, job_step_kill_msg_t, job_step_id),
+	PACK_FIELD(STR, job_step_kill_msg_t, sibling),
+	PACK_FIELD(16, job_step_kill_msg_t, signal),
+	PACK_FIELD(16, job_step_kill_msg_t, flags),
+};
+
 static void
 _pack_job_step_kill_msg(job_step_kill_msg_t * msg, Buf buffer,
 			uint16_t protocol_version)
 {
 	if (protocol_version >= SLURM_17_11_PROTOCOL_VERSION) {
-		packstr(msg->sjob_id, buffer);
-		pack32((uint32_t)msg->job_id, buffer);
-		pack32((uint32_t)msg->job_step_id, buffer);
-		packstr(msg->sibling, buffer);
-		pack16((uint16_t)msg->signal, buffer);
-		pack16((uint16_t)msg->flags, buffer);
+		pack_fields(job_step_kill_fields,
+			    PACK_FIELD_CNT(job_step_kill_fields), msg, buffer);
 	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		packstr(msg->sjob_id, buffer);
 		pack32((uint32_t)msg->job_id, buffer);
@@ -10193,12 +10334,9 @@ _unpack_job_step_kill_msg(job_step_kill_msg_t ** msg_ptr, Buf buffer,
 	*msg_ptr = msg;
 
 	if (protocol_version >= SLURM_17_11_PROTOCOL_VERSION) {
-		safe_unpackstr_xmalloc(&(msg)->sjob_id, &cc, buffer);
-		safe_unpack32(&msg->job_id, buffer);
-		safe_unpack32(&msg->job_step_id, buffer);
-		safe_unpackstr_xmalloc(&msg->sibling, &cc, buffer);
-		safe_unpack16(&msg->signal, buffer);
-		safe_unpack16(&msg->flags, buffer);
+		safe_unpack_fields(job_step_kill_fields,
+				   PACK_FIELD_CNT(job_step_kill_fields),
+				   msg, buffer);
 	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpackstr_xmalloc(&(msg)->sjob_id, &cc, buffer);
 		safe_unpack32(&msg->job_id, buffer);
@@ -10508,6 +10646,14 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+static const pack_field_t complete_batch_fields[] = {
+	PACK_FIELD(32, complete_batch_script_msg_t, job_id),
+	PACK_FIELD(32, complete_batch_script_msg_t, job_rc),
+	PACK_FIELD(32, complete_batch_script_msg_t, slurm_rc),
+	PACK_FIELD(32, complete_batch_script_msg_t, user_id),
+	PACK_FIELD(STR, complete_batch_script_msg_t, node_name),
+};
+
 static void
 _pack_complete_batch_script_msg(
 	complete_batch_script_msg_t * msg, Buf buffer,
@@ -10516,11 +10662,8 @@ _pack_complete_batch_script_msg(
 	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		jobacctinfo_pack(msg->jobacct, protocol_version,
 				 PROTOCOL_TYPE_SLURM, buffer);
-		pack32(msg->job_id, buffer);
-		pack32(msg->job_rc, buffer);
-		pack32(msg->slurm_rc, buffer);
-		pack32(msg->user_id, buffer);
-		packstr(msg->node_name, buffer);
+		pack_fields(complete_batch_fields,
+			    PACK_FIELD_CNT(complete_batch_fields), msg, buffer);
 	} else {
 		error("_pack_complete_batch_script_msg: protocol_version "
 		      "%hu not supported", protocol_version);
@@ -10533,7 +10676,6 @@ _unpack_complete_batch_script_msg(
 	uint16_t protocol_version)
 {
 	complete_batch_script_msg_t *msg;
-	uint32_t uint32_tmp;
 
 	msg = xmalloc(sizeof(complete_batch_script_msg_t));
 	*msg_ptr = msg;
@@ -10543,11 +10685,9 @@ _unpack_complete_batch_script_msg(
 				       PROTOCOL_TYPE_SLURM, buffer, 1)
 		    != SLURM_SUCCESS)
 			goto unpack_error;
-		safe_unpack32(&msg->job_id, buffer);
-		safe_unpack32(&msg->job_rc, buffer);
-		safe_unpack32(&msg->slurm_rc, buffer);
-		safe_unpack32(&msg->user_id, buffer);
-		safe_unpackstr_xmalloc(&msg->node_name, &uint32_tmp, buffer);
+		safe_unpack_fields(complete_batch_fields,
+				   PACK_FIELD_CNT(complete_batch_fields),
+				   msg, buffer);
 	} else {
 		error("_unpack_complete_batch_script_msg: protocol_version "
 		      "%hu not supported", protocol_version);
@@ -10662,15 +10802,20 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+static const pack_field_t step_complete_fields[] = {
+	PACK_FIELD(32, step_complete_msg_t, job_id),
+	PACK_FIELD(32, step_complete_msg_t, job_step_id),
+	PACK_FIELD(32, step_complete_msg_t, range_first),
+	PACK_FIELD(32, step_complete_msg_t, range_last),
+	PACK_FIELD(32, step_complete_msg_t, step_rc),
+};
+
 static void
 _pack_step_complete_msg(step_complete_msg_t * msg, Buf buffer,
 			uint16_t protocol_version)
 {
-	pack32((uint32_t)msg->job_id, buffer);
-	pack32((uint32_t)msg->job_step_id, buffer);
-	pack32((uint32_t)msg->range_first, buffer);
-	pack32((uint32_t)msg->range_last, buffer);
-	pack32((uint32_t)msg->step_rc, buffer);
+	pack_fields(step_complete_fields, PACK_FIELD_CNT(step_complete_fields),
+		    msg, buffer);
 	jobacctinfo_pack(msg->jobacct, protocol_version,
 			 PROTOCOL_TYPE_SLURM, buffer);
 }
@@ -10684,11 +10829,8 @@ _unpack_step_complete_msg(step_complete_msg_t ** msg_ptr, Buf buffer,
 	msg = xmalloc(sizeof(step_complete_msg_t));
 	*msg_ptr = msg;
 
-	safe_unpack32(&msg->job_id, buffer);
-	safe_unpack32(&msg->job_step_id, buffer);
-	safe_unpack32(&msg->range_first, buffer);
-	safe_unpack32(&msg->range_last, buffer);
-	safe_unpack32(&msg->step_rc, buffer);
+	safe_unpack_fields(step_complete_fields,
+			   PACK_FIELD_CNT(step_complete_fields), msg, buffer);
 	if (jobacctinfo_unpack(&msg->jobacct, protocol_version,
 			       PROTOCOL_TYPE_SLURM, buffer, 1)
 	    != SLURM_SUCCESS)
@@ -11691,6 +11833,289 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+/*
+ * Replies that carry nothing beyond a return code can be merged: a forward
+ * tree of thousands of nodes mostly returns the same few results.
+ */
+static bool _ret_summarizable(uint16_t type, void *data)
+{
+	if (type == RESPONSE_FORWARD_FAILED)
+		return (data == NULL);
+	if (type == RESPONSE_SLURM_RC)
+		return (data != NULL);
+	return false;
+}
+
+/*
+ * Replies whose bodies differ for every node but are small, like the load
+ * reported in a ping. These are packed as a node table bitmap followed by
+ * one body per node rather than as separately named records.
+ */
+static bool _ret_indexable(uint16_t type, uint16_t protocol_version)
+{
+	if (protocol_version < SLURM_17_11_FWD_PROTOCOL_VERSION)
+		return false;
+	return (type == RESPONSE_PING_SLURMD);
+}
+
+/*
+ * Forms of a packed ret_list summary record, each record starts with one
+ * (SLURM_17_11_FWD_PROTOCOL_VERSION and later only)
+ */
+#define RET_FORM_NAMES	0	/* ranged node names and one shared body */
+#define RET_FORM_INDEX	1	/* node table bitmap and a body per node */
+
+typedef struct {
+	uint32_t err;
+	uint16_t type;
+	uint32_t rc;
+	hostlist_t hl;			/* NULL if not summarizable */
+	bitstr_t *nodes;		/* node indexes, RET_FORM_INDEX */
+	ret_data_info_t **node_recs;	/* record of each index in nodes */
+	ret_data_info_t *ret_data_info;	/* record whose body is packed */
+} ret_group_t;
+
+/*
+ * Pack a ret_list with records of equal result merged into one record
+ * holding a ranged list of node names. If index_ok is set, because the
+ * receiver is known to index nodes as we do, indexable replies such as
+ * pings are merged into one record holding a node table bitmap and each
+ * node's body. _unpack_ret_summary() expands them back so callers still
+ * see one record per node.
+ * RET number of records packed
+ */
+static uint16_t _pack_ret_summary(List ret_list, Buf buffer,
+				  uint16_t protocol_version, bool index_ok)
+{
+	ListIterator itr;
+	ret_data_info_t *ret_data_info;
+	ret_group_t *groups = NULL;
+	int group_cnt = 0, group_size = 0, i, j, node_inx, node_cnt = -1;
+	uint32_t rc;
+	bool merge, new_index;
+	char *names;
+	slurm_msg_t msg;
+
+	itr = list_iterator_create(ret_list);
+	while ((ret_data_info = list_next(itr))) {
+		node_inx = -1;
+		if (index_ok && ret_data_info->node_name &&
+		    ret_data_info->data &&
+		    _ret_indexable(ret_data_info->type, protocol_version)) {
+			if (node_cnt < 0)
+				node_cnt = slurm_conf_get_node_table(NULL);
+			node_inx = slurm_conf_get_node_index(
+				ret_data_info->node_name);
+		}
+		for (i = 0; (node_inx >= 0) && (i < group_cnt); i++) {
+			if (groups[i].nodes &&
+			    (groups[i].err == ret_data_info->err) &&
+			    (groups[i].type == ret_data_info->type))
+				break;
+		}
+		if ((node_inx >= 0) && (i < group_cnt) &&
+		    !bit_test(groups[i].nodes, node_inx)) {
+			bit_set(groups[i].nodes, node_inx);
+			groups[i].node_recs[node_inx] = ret_data_info;
+			continue;
+		}
+		/* First record of its kind starts an indexed group */
+		new_index = (node_inx >= 0) && (i == group_cnt);
+
+		merge = ret_data_info->node_name &&
+			_ret_summarizable(ret_data_info->type,
+					  ret_data_info->data);
+		rc = 0;
+		if (merge && (ret_data_info->type == RESPONSE_SLURM_RC))
+			rc = ((return_code_msg_t *)
+			      ret_data_info->data)->return_code;
+		for (i = 0; merge && (i < group_cnt); i++) {
+			if (groups[i].hl &&
+			    (groups[i].err == ret_data_info->err) &&
+			    (groups[i].type == ret_data_info->type) &&
+			    (groups[i].rc == rc))
+				break;
+		}
+		if (merge && (i < group_cnt)) {
+			hostlist_push_host(groups[i].hl,
+					   ret_data_info->node_name);
+			continue;
+		}
+
+		if (group_cnt >= group_size) {
+			group_size = MAX(group_size * 2, 16);
+			xrealloc(groups, sizeof(ret_group_t) * group_size);
+		}
+		groups[group_cnt].err = ret_data_info->err;
+		groups[group_cnt].type = ret_data_info->type;
+		groups[group_cnt].rc = rc;
+		groups[group_cnt].ret_data_info = ret_data_info;
+		groups[group_cnt].nodes = NULL;
+		groups[group_cnt].node_recs = NULL;
+		if (new_index) {
+			groups[group_cnt].hl = NULL;
+			groups[group_cnt].nodes = bit_alloc(node_cnt);
+			groups[group_cnt].node_recs =
+				xmalloc(sizeof(ret_data_info_t *) * node_cnt);
+			bit_set(groups[group_cnt].nodes, node_inx);
+			groups[group_cnt].node_recs[node_inx] = ret_data_info;
+		} else if (merge) {
+			groups[group_cnt].hl = hostlist_create(NULL);
+			hostlist_push_host(groups[group_cnt].hl,
+					   ret_data_info->node_name);
+		} else
+			groups[group_cnt].hl = NULL;
+		group_cnt++;
+	}
+	list_iterator_destroy(itr);
+	xassert(group_cnt <= NO_VAL16);
+
+	slurm_msg_t_init(&msg);
+	msg.protocol_version = protocol_version;
+	for (i = 0; i < group_cnt; i++) {
+		pack32(groups[i].err, buffer);
+		pack16(groups[i].type, buffer);
+		msg.msg_type = groups[i].type;
+		if (groups[i].nodes) {
+			xassert(protocol_version >=
+				SLURM_17_11_FWD_PROTOCOL_VERSION);
+			pack8(RET_FORM_INDEX, buffer);
+			_pack_forward_nodes(groups[i].nodes, buffer);
+			for (j = 0; j < node_cnt; j++) {
+				if (!bit_test(groups[i].nodes, j))
+					continue;
+				msg.data = groups[i].node_recs[j]->data;
+				pack_msg(&msg, buffer);
+			}
+			FREE_NULL_BITMAP(groups[i].nodes);
+			xfree(groups[i].node_recs);
+			continue;
+		}
+
+		if (protocol_version >= SLURM_17_11_FWD_PROTOCOL_VERSION)
+			pack8(RET_FORM_NAMES, buffer);
+		if (groups[i].hl) {
+			names = hostlist_ranged_string_xmalloc(groups[i].hl);
+			packstr(names, buffer);
+			xfree(names);
+			hostlist_destroy(groups[i].hl);
+		} else
+			packstr(groups[i].ret_data_info->node_name, buffer);
+
+		msg.data = groups[i].ret_data_info->data;
+		pack_msg(&msg, buffer);
+	}
+	xfree(groups);
+
+	return (uint16_t) group_cnt;
+}
+
+static int _unpack_ret_summary(List *ret_list, uint16_t group_cnt, Buf buffer,
+			       uint16_t protocol_version)
+{
+	int i, j, node_cnt;
+	uint32_t err, uint32_tmp;
+	uint16_t type;
+	uint8_t form;
+	char *names = NULL, *name;
+	hostlist_t hl;
+	bitstr_t *nodes = NULL;
+	ret_data_info_t *ret_data_info;
+	return_code_msg_t *rc_msg;
+	slurm_msg_t msg;
+
+	slurm_msg_t_init(&msg);
+	msg.protocol_version = protocol_version;
+
+	*ret_list = list_create(destroy_data_info);
+
+	for (i = 0; i < group_cnt; i++) {
+		safe_unpack32(&err, buffer);
+		safe_unpack16(&type, buffer);
+		if (protocol_version >= SLURM_17_11_FWD_PROTOCOL_VERSION)
+			safe_unpack8(&form, buffer);
+		else
+			form = RET_FORM_NAMES;
+		msg.msg_type = type;
+		if (form == RET_FORM_INDEX) {
+			if (!_ret_indexable(type, protocol_version) ||
+			    _unpack_forward_nodes(&nodes, buffer))
+				goto unpack_error;
+			node_cnt = bit_size(nodes);
+			for (j = 0; j < node_cnt; j++) {
+				if (!bit_test(nodes, j))
+					continue;
+				msg.data = NULL;
+				if (unpack_msg(&msg, buffer) != SLURM_SUCCESS)
+					goto unpack_error;
+				ret_data_info = xmalloc(sizeof(ret_data_info_t));
+				ret_data_info->err = err;
+				ret_data_info->type = type;
+				ret_data_info->node_name =
+					slurm_conf_get_node_by_index(j);
+				ret_data_info->data = msg.data;
+				list_push(*ret_list, ret_data_info);
+			}
+			FREE_NULL_BITMAP(nodes);
+			continue;
+		} else if (form != RET_FORM_NAMES)
+			goto unpack_error;
+
+		safe_unpackstr_xmalloc(&names, &uint32_tmp, buffer);
+		msg.data = NULL;
+		if (unpack_msg(&msg, buffer) != SLURM_SUCCESS)
+			goto unpack_error;
+
+		ret_data_info = xmalloc(sizeof(ret_data_info_t));
+		ret_data_info->err = err;
+		ret_data_info->type = type;
+		ret_data_info->data = msg.data;
+		list_push(*ret_list, ret_data_info);
+
+		/* A single node name needs no expanding */
+		if (!names || !strpbrk(names, "[,")) {
+			ret_data_info->node_name = names;
+			names = NULL;
+			continue;
+		}
+
+		if (!_ret_summarizable(type, msg.data)) {
+			error("%s: message type %u can not be summarized",
+			      __func__, type);
+			goto unpack_error;
+		}
+		hl = hostlist_create(names);
+		xfree(names);
+		name = hostlist_shift(hl);
+		ret_data_info->node_name = xstrdup(name);
+		free(name);
+		while ((name = hostlist_shift(hl))) {
+			ret_data_info = xmalloc(sizeof(ret_data_info_t));
+			ret_data_info->err = err;
+			ret_data_info->type = type;
+			ret_data_info->node_name = xstrdup(name);
+			free(name);
+			if (type == RESPONSE_SLURM_RC) {
+				rc_msg = xmalloc(sizeof(return_code_msg_t));
+				rc_msg->return_code = ((return_code_msg_t *)
+						       msg.data)->return_code;
+				ret_data_info->data = rc_msg;
+			}
+			list_push(*ret_list, ret_data_info);
+		}
+		hostlist_destroy(hl);
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	error("%s: record %d of %u", __func__, i, group_cnt);
+	FREE_NULL_BITMAP(nodes);
+	xfree(names);
+	FREE_NULL_LIST(*ret_list);
+	return SLURM_ERROR;
+}
+
 static void
 _pack_batch_job_launch_msg(batch_job_launch_msg_t * msg, Buf buffer,
 			   uint16_t protocol_version)
@@ -13974,14 +14399,6 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
-/* _pack_license_info_msg()
- */
-static inline void
-_pack_license_info_msg(slurm_msg_t *msg, Buf buffer)
-{
-	_pack_buffer_msg(msg, buffer);
-}
-
 /* _unpack_license_info_msg()
  *
  * Decode the array of license as it comes from the
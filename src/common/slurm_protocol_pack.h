@@ -80,6 +80,13 @@ extern int unpack_header ( header_t * header , Buf buffer );
  */
 extern int pack_msg ( slurm_msg_t const * msg , Buf buffer );
 
+/* pack_msg_is_buffer
+ * IN msg_type - message type
+ * RET true if the body of such a message is already packed by the sender
+ *	(msg->data of msg->data_size bytes) and pack_msg() only copies it
+ */
+extern bool pack_msg_is_buffer(uint16_t msg_type);
+
 /* unpack_msg
  * unpacks a generic slurm protocol message body
  * OUT msg - the body structure to unpack (note: includes message type)
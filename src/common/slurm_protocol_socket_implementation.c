@@ -170,38 +170,25 @@ extern ssize_t slurm_msg_sendto(int fd, char *buffer, size_t size,
 ssize_t slurm_msg_sendto_timeout(int fd, char *buffer, size_t size,
 				 uint32_t flags, int timeout)
 {
-	int   len;
-	uint32_t usize;
-	SigFunc *ohandler;
-
-	/*
-	 *  Ignore SIGPIPE so that send can return a error code if the
-	 *    other side closes the socket
-	 */
-	ohandler = xsignal(SIGPIPE, SIG_IGN);
-
-	usize = htonl(size);
-
-	if ((len = slurm_send_timeout(
-				fd, (char *)&usize, sizeof(usize), 0,
-				timeout)) < 0)
-		goto done;
+	struct iovec iov;
 
-	if ((len = slurm_send_timeout(fd, buffer, size, 0, timeout)) < 0)
-		goto done;
+	iov.iov_base = buffer;
+	iov.iov_len = size;
 
-
-     done:
-	xsignal(SIGPIPE, ohandler);
-	return len;
+	return slurm_msg_sendv_timeout(fd, &iov, 1, flags, timeout);
 }
 
-/* Send slurm message with timeout
- * RET message size (as specified in argument) or SLURM_ERROR on error */
-extern int slurm_send_timeout(int fd, char *buf, size_t size,
-			      uint32_t flags, int timeout)
+/*
+ * Write out the iovec array with sendmsg(), picking up where a partial
+ * write left off. The iovec array is modified.
+ * RET bytes sent (the sum of the iov_len) or SLURM_ERROR on error
+ */
+static int _send_iov_timeout(int fd, struct iovec *iov, int iovcnt,
+			     uint32_t flags, int timeout)
 {
-	int rc;
+	struct msghdr msg;
+	size_t size = 0;
+	int i, rc;
 	int sent = 0;
 	int fd_flags;
 	struct pollfd ufds;
@@ -209,6 +196,9 @@ extern int slurm_send_timeout(int fd, char *buf, size_t size,
 	int timeleft = timeout;
 	char temp[2];
 
+	for (i = 0; i < iovcnt; i++)
+		size += iov[i].iov_len;
+
 	ufds.fd     = fd;
 	ufds.events = POLLOUT;
 
@@ -265,7 +255,10 @@ extern int slurm_send_timeout(int fd, char *buf, size_t size,
 			      ufds.revents);
 		}
 
-		rc = send(fd, &buf[sent], (size - sent), flags);
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = iov;
+		msg.msg_iovlen = iovcnt;
+		rc = sendmsg(fd, &msg, flags);
 		if (rc < 0) {
  			if (errno == EINTR)
 				continue;
@@ -289,6 +282,19 @@ extern int slurm_send_timeout(int fd, char *buf, size_t size,
 		}
 
 		sent += rc;
+
+		/* Skip over whatever part of the iovec array went out */
+		while (rc > 0) {
+			if (rc >= iov->iov_len) {
+				rc -= iov->iov_len;
+				iov++;
+				iovcnt--;
+			} else {
+				iov->iov_base = (char *) iov->iov_base + rc;
+				iov->iov_len -= rc;
+				rc = 0;
+			}
+		}
 	}
 
     done:
@@ -303,6 +309,52 @@ extern int slurm_send_timeout(int fd, char *buf, size_t size,
 
 }
 
+extern ssize_t slurm_msg_sendv_timeout(int fd, struct iovec *iov, int iovcnt,
+				       uint32_t flags, int timeout)
+{
+	struct iovec msg_iov[iovcnt + 1];
+	size_t size = 0;
+	uint32_t usize;
+	SigFunc *ohandler;
+	int i, len;
+
+	for (i = 0; i < iovcnt; i++) {
+		size += iov[i].iov_len;
+		msg_iov[i + 1] = iov[i];
+	}
+
+	/*
+	 *  Ignore SIGPIPE so that send can return a error code if the
+	 *    other side closes the socket
+	 */
+	ohandler = xsignal(SIGPIPE, SIG_IGN);
+
+	/* The length prefix goes out in the same sendmsg() as the data */
+	usize = htonl(size);
+	msg_iov[0].iov_base = &usize;
+	msg_iov[0].iov_len = sizeof(usize);
+
+	len = _send_iov_timeout(fd, msg_iov, iovcnt + 1, flags, timeout);
+	if (len > 0)
+		len -= sizeof(usize);
+
+	xsignal(SIGPIPE, ohandler);
+	return len;
+}
+
+/* Send slurm message with timeout
+ * RET message size (as specified in argument) or SLURM_ERROR on error */
+extern int slurm_send_timeout(int fd, char *buf, size_t size,
+			      uint32_t flags, int timeout)
+{
+	struct iovec iov;
+
+	iov.iov_base = buf;
+	iov.iov_len = size;
+
+	return _send_iov_timeout(fd, &iov, 1, flags, timeout);
+}
+
 /* Get slurm message with timeout
  * RET message size (as specified in argument) or SLURM_ERROR on error */
 extern int slurm_recv_timeout(int fd, char *buffer, size_t size,
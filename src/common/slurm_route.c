@@ -84,12 +84,18 @@ static pthread_mutex_t g_context_lock = PTHREAD_MUTEX_INITIALIZER;
 static bool init_run = false;
 static uint32_t debug_flags = 0;
 static uint16_t g_tree_width;
+static bool adapt_tree_width = false;	/* TopologyParam=AdaptiveTreeWidth */
 static bool this_is_collector = false; /* this node is a collector node */
 static slurm_addr_t *msg_collect_node = NULL; /* address of node to aggregate
 						 messages from this node */
 static slurm_addr_t *msg_collect_backup = NULL; /* address of backup node to
 						   aggregate messages from this node */
 
+/* Nodes known to be slow or not responding, as node table indexes */
+static pthread_mutex_t slow_lock = PTHREAD_MUTEX_INITIALIZER;
+static bitstr_t *slow_nodes = NULL;
+static int slow_cnt = 0;
+
 
 /* _get_all_nodes creates a hostlist containing all the nodes in the
  * node_record_table.
@@ -273,7 +279,7 @@ extern int route_init(char *node_name)
 {
 	int retval = SLURM_SUCCESS;
 	char *plugin_type = "route";
-	char *type = NULL;
+	char *type = NULL, *topology_param;
 
 	if (init_run && g_context)
 		return retval;
@@ -296,6 +302,10 @@ extern int route_init(char *node_name)
 
 	g_tree_width = slurm_get_tree_width();
 	debug_flags = slurm_get_debug_flags();
+	topology_param = slurm_get_topology_param();
+	adapt_tree_width = (xstrcasestr(topology_param, "AdaptiveTreeWidth") !=
+			    NULL);
+	xfree(topology_param);
 
 	init_run = true;
 	_set_collectors(node_name);
@@ -310,6 +320,11 @@ extern int route_fini(void)
 {
 	int rc;
 
+	slurm_mutex_lock(&slow_lock);
+	FREE_NULL_BITMAP(slow_nodes);
+	slow_cnt = 0;
+	slurm_mutex_unlock(&slow_lock);
+
 	if (!g_context)
 		return SLURM_SUCCESS;
 
@@ -324,6 +339,141 @@ extern int route_fini(void)
 }
 
 
+/*
+ * route_set_node_slow - record whether a node is known to be slow or not
+ *	responding. Such nodes are never asked to forward a message for
+ *	others, see _remove_slow_nodes().
+ */
+extern void route_set_node_slow(const char *node_name, bool slow)
+{
+	int index, node_cnt;
+
+	slurm_mutex_lock(&slow_lock);
+	if (!slow && !slow_cnt) {	/* Common case, nothing to clear */
+		slurm_mutex_unlock(&slow_lock);
+		return;
+	}
+	slurm_mutex_unlock(&slow_lock);
+
+	if ((index = slurm_conf_get_node_index(node_name)) < 0)
+		return;
+	node_cnt = slurm_conf_get_node_table(NULL);
+
+	slurm_mutex_lock(&slow_lock);
+	if (slow_nodes && (bit_size(slow_nodes) != node_cnt)) {
+		/* Node table rebuilt, the recorded indexes are stale */
+		FREE_NULL_BITMAP(slow_nodes);
+		slow_cnt = 0;
+	}
+	if (!slow_nodes)
+		slow_nodes = bit_alloc(node_cnt);
+	if (index < node_cnt) {
+		if (slow && !bit_test(slow_nodes, index)) {
+			bit_set(slow_nodes, index);
+			slow_cnt++;
+		} else if (!slow && bit_test(slow_nodes, index)) {
+			bit_clear(slow_nodes, index);
+			slow_cnt--;
+		}
+	}
+	slurm_mutex_unlock(&slow_lock);
+}
+
+/*
+ * Take up to max_cnt known slow nodes out of hl. Each is then sent the
+ * message directly as a leaf, rather than heading a subtree whose every
+ * node would wait for it to time out.
+ * RET hostlist of removed nodes or NULL if none
+ */
+static hostlist_t _remove_slow_nodes(hostlist_t hl, int max_cnt)
+{
+	hostlist_t slow_hl = NULL;
+	hostlist_iterator_t iter;
+	bitstr_t *hl_nodes;
+	char *name;
+	int i, index, node_cnt;
+
+	slurm_mutex_lock(&slow_lock);
+	if (!slow_cnt) {
+		slurm_mutex_unlock(&slow_lock);
+		return NULL;
+	}
+	slurm_mutex_unlock(&slow_lock);
+
+	/* Resolve hl to node indexes without holding slow_lock */
+	node_cnt = slurm_conf_get_node_table(NULL);
+	if (node_cnt <= 0)
+		return NULL;
+	hl_nodes = bit_alloc(node_cnt);
+	iter = hostlist_iterator_create(hl);
+	while ((name = hostlist_next(iter))) {
+		index = slurm_conf_get_node_index(name);
+		if ((index >= 0) && (index < node_cnt))
+			bit_set(hl_nodes, index);
+		free(name);
+	}
+	hostlist_iterator_destroy(iter);
+
+	slurm_mutex_lock(&slow_lock);
+	if (slow_nodes && (bit_size(slow_nodes) == node_cnt))
+		bit_and(hl_nodes, slow_nodes);
+	else
+		bit_nclear(hl_nodes, 0, node_cnt - 1);
+	slurm_mutex_unlock(&slow_lock);
+
+	for (i = bit_ffs(hl_nodes); (i >= 0) && (i < node_cnt) &&
+	     (max_cnt > 0); i++) {
+		if (!bit_test(hl_nodes, i))
+			continue;
+		if (!(name = slurm_conf_get_node_by_index(i)))
+			continue;
+		hostlist_delete_host(hl, name);
+		if (!slow_hl)
+			slow_hl = hostlist_create(NULL);
+		hostlist_push_host(slow_hl, name);
+		max_cnt--;
+		xfree(name);
+	}
+	FREE_NULL_BITMAP(hl_nodes);
+
+	return slow_hl;
+}
+
+/* Return how many levels a tree of the given width needs for host_cnt
+ * nodes, each branch head forwarding to the rest of its branch */
+static int _tree_depth(int host_cnt, int width)
+{
+	int64_t level = 1, covered = 0;
+	int depth = 0;
+
+	while (covered < host_cnt) {
+		level *= width;
+		covered += level;
+		depth++;
+	}
+	return depth;
+}
+
+/*
+ * Return the smallest width up to tree_width which reaches host_cnt nodes
+ * in as few levels as tree_width would. Every hop splits its own branch
+ * again, so each uses the fewest threads its branch size allows.
+ */
+static uint16_t _adapt_width(int host_cnt, uint16_t tree_width)
+{
+	int depth;
+	uint16_t width;
+
+	if ((host_cnt <= tree_width) || (tree_width <= 2))
+		return tree_width;
+	depth = _tree_depth(host_cnt, tree_width);
+	for (width = 2; width < tree_width; width++) {
+		if (_tree_depth(host_cnt, width) <= depth)
+			break;
+	}
+	return width;
+}
+
 /*
  * route_g_split_hostlist - logic to split an input hostlist into
  *                          a set of hostlists to forward to.
@@ -344,8 +494,10 @@ extern int route_g_split_hostlist(hostlist_t hl,
 				  int* count, uint16_t tree_width)
 {
 	int rc;
-	int j, nnodes, nnodex;
+	int j, nnodes, nnodex, slow_hl_cnt = 0;
+	uint16_t split_width;
 	char *buf;
+	hostlist_t slow_hl;
 
 	nnodes = nnodex = 0;
 	if (route_init(NULL) != SLURM_SUCCESS)
@@ -361,8 +513,35 @@ extern int route_g_split_hostlist(hostlist_t hl,
 		xfree(buf);
 	}
 
-	rc = (*(ops.split_hostlist))(hl, sp_hl, count,
-				     tree_width ? tree_width : g_tree_width);
+	if (!tree_width)
+		tree_width = g_tree_width;
+	/* Slow nodes take branches of their own, within tree_width */
+	if ((slow_hl = _remove_slow_nodes(hl, tree_width - 1)))
+		slow_hl_cnt = hostlist_count(slow_hl);
+	split_width = MAX(tree_width - slow_hl_cnt, 1);
+	if (adapt_tree_width)
+		split_width = _adapt_width(hostlist_count(hl), split_width);
+
+	if (hostlist_count(hl)) {
+		rc = (*(ops.split_hostlist))(hl, sp_hl, count, split_width);
+	} else {
+		*sp_hl = NULL;
+		*count = 0;
+		rc = SLURM_SUCCESS;
+	}
+
+	if (slow_hl) {
+		/* Append each slow node as a branch of its own */
+		xrealloc(*sp_hl, sizeof(hostlist_t) * (*count + slow_hl_cnt));
+		while ((buf = hostlist_shift(slow_hl))) {
+			(*sp_hl)[(*count)++] = hostlist_create(buf);
+			if (debug_flags & DEBUG_FLAG_ROUTE)
+				info("ROUTE: slow node %s sent as a leaf", buf);
+			free(buf);
+		}
+		hostlist_destroy(slow_hl);
+	}
+
 	if (debug_flags & DEBUG_FLAG_ROUTE) {
 		/* Sanity check to make sure all nodes in msg list are in
 		 * a child list */
@@ -386,6 +565,12 @@ extern int route_g_split_hostlist(hostlist_t hl,
  */
 extern int route_g_reconfigure(void)
 {
+	/* The node table may have been rebuilt, invalidating the indexes */
+	slurm_mutex_lock(&slow_lock);
+	FREE_NULL_BITMAP(slow_nodes);
+	slow_cnt = 0;
+	slurm_mutex_unlock(&slow_lock);
+
 	if (route_init(NULL) != SLURM_SUCCESS)
 		return SLURM_ERROR;
 	debug_flags = slurm_get_debug_flags();
@@ -83,6 +83,16 @@ extern int route_g_split_hostlist(hostlist_t hl,
 				  hostlist_t** sp_hl,
 				  int* count, uint16_t tree_width);
 
+/*
+ * route_set_node_slow - record whether a node is known to be slow or not
+ *                       responding. route_g_split_hostlist() sends to such
+ *                       nodes as leaves of the tree, never as forwarders.
+ *
+ * IN: node_name - char * - NodeName of the node
+ * IN: slow      - bool   - true if slow, false once it responds normally
+ */
+extern void route_set_node_slow(const char *node_name, bool slow);
+
 /*
  * route_g_reconfigure - reset during reconfigure
  *
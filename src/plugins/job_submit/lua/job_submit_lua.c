@@ -93,19 +93,46 @@ const char plugin_name[]       	= "Job submit lua plugin";
 const char plugin_type[]       	= "job_submit/lua";
 const uint32_t plugin_version   = SLURM_VERSION_NUMBER;
 
+/*
+ * Maximum number of Lua states kept loaded with the script. A script which
+ * sets "slurm.thread_safe = true" is loaded into this many states so that
+ * job_submit() and job_modify() calls can be evaluated in parallel. Any other
+ * script gets a single state and calls are serialized.
+ */
+#define LUA_POOL_SIZE	8
+
+/* Per call latency histogram bucket limits, in microseconds */
+#define LUA_HIST_BUCKETS 6
+static const long lua_hist_limit[LUA_HIST_BUCKETS - 1] =
+	{ 100, 1000, 10000, 100000, 1000000 };
+
+typedef struct lua_pool_ent {
+	lua_State *L;
+	bool in_use;
+	time_t last_jobs_update;	/* slurm.jobs built at this time */
+	time_t last_resv_update;	/* slurm.reservations built at this */
+} lua_pool_ent_t;
+
 static const char lua_script_path[] = DEFAULT_SCRIPT_DIR "/job_submit.lua";
 static time_t lua_script_last_loaded = (time_t) 0;
-static lua_State *L = NULL;
-static char *user_msg = NULL;
-
-time_t last_lua_jobs_update = (time_t) 0;
-time_t last_lua_resv_update = (time_t) 0;
+static lua_pool_ent_t lua_pool[LUA_POOL_SIZE];
+static int lua_pool_cnt = 0;		/* Loaded states in lua_pool */
+static int lua_pool_busy = 0;		/* States currently in use */
+static uint32_t lua_hist_submit[LUA_HIST_BUCKETS];
+static uint32_t lua_hist_modify[LUA_HIST_BUCKETS];
+
+/* The Lua state and pool entry in use by this thread. All of the helper
+ * functions below operate on these. */
+static __thread lua_State *L = NULL;
+static __thread lua_pool_ent_t *lua_ent = NULL;
+static __thread char *user_msg = NULL;
 
 /*
- *  Mutex for protecting multi-threaded access to this plugin.
- *   (Only 1 thread at a time should be in here)
+ *  Mutex protecting the pool of Lua states and the histograms above.
+ *  Each Lua state is used by only one thread at a time.
  */
 static pthread_mutex_t lua_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t lua_pool_cond = PTHREAD_COND_INITIALIZER;
 
 /* These are defined here so when we link with something other than
  * the slurmctld we will have these symbols defined.  They will get
@@ -421,14 +448,113 @@ static int _job_rec_field_index(lua_State *L)
 	return _job_rec_field(job_ptr, name);
 }
 
-/* Get the list of existing slurmctld job records. */
+static void _push_job_rec(struct job_record *job_ptr);
+
+#ifndef HAVE_LUA_5_1
+/* Look up a job for the slurm.jobs proxy table. Keys are job IDs as strings
+ * (as returned by pairs()) or numbers. */
+static int _jobs_proxy_index(lua_State *L)
+{
+	struct job_record *job_ptr = NULL;
+	const char *key;
+	char *end_ptr = NULL;
+	uint32_t job_id = 0;
+
+	if (lua_type(L, 2) == LUA_TNUMBER) {
+		job_id = (uint32_t) lua_tonumber(L, 2);
+	} else if ((key = lua_tostring(L, 2))) {
+		job_id = (uint32_t) strtoul(key, &end_ptr, 10);
+		if (end_ptr[0] != '\0')
+			job_id = 0;
+	}
+	if (job_id)
+		job_ptr = find_job_record(job_id);
+	if (!job_ptr) {
+		lua_pushnil(L);
+		return 1;
+	}
+	_push_job_rec(job_ptr);
+
+	return 1;
+}
+
+/* Iterator for pairs(slurm.jobs). Upvalue 1 is an array of the job IDs which
+ * existed when iteration began, upvalue 2 is the next position in it. */
+static int _jobs_proxy_next(lua_State *L)
+{
+	char job_id_buf[11]; /* Big enough for a uint32_t */
+	struct job_record *job_ptr = NULL;
+	int inx = (int) lua_tointeger(L, lua_upvalueindex(2));
+
+	while (!job_ptr) {
+		lua_rawgeti(L, lua_upvalueindex(1), inx++);
+		if (lua_isnil(L, -1))
+			return 1;
+		job_ptr = find_job_record((uint32_t) lua_tonumber(L, -1));
+		lua_pop(L, 1);
+	}
+	lua_pushinteger(L, inx);
+	lua_replace(L, lua_upvalueindex(2));
+
+	snprintf(job_id_buf, sizeof(job_id_buf), "%u", job_ptr->job_id);
+	lua_pushstring(L, job_id_buf);
+	_push_job_rec(job_ptr);
+
+	return 2;
+}
+
+static int _jobs_proxy_pairs(lua_State *L)
+{
+	ListIterator iter;
+	struct job_record *job_ptr;
+	int inx = 1;
+
+	lua_newtable(L);
+	iter = list_iterator_create(job_list);
+	while ((job_ptr = (struct job_record *) list_next(iter))) {
+		lua_pushnumber(L, job_ptr->job_id);
+		lua_rawseti(L, -2, inx++);
+	}
+	list_iterator_destroy(iter);
+	lua_pushinteger(L, 1);
+	lua_pushcclosure(L, _jobs_proxy_next, 2);
+
+	return 1;
+}
+
+/* Install slurm.jobs as an empty proxy table whose metatable looks up job
+ * records on demand, so the cost of a submission does not depend upon the
+ * number of jobs. The proxy stays valid as jobs come and go, so it is only
+ * built once per script load. */
+static void _update_jobs_global(void)
+{
+	if (lua_ent->last_jobs_update)
+		return;
+
+	lua_getglobal(L, "slurm");
+	lua_newtable(L);
+
+	lua_newtable(L);
+	lua_pushcfunction(L, _jobs_proxy_index);
+	lua_setfield(L, -2, "__index");
+	lua_pushcfunction(L, _jobs_proxy_pairs);
+	lua_setfield(L, -2, "__pairs");
+	lua_setmetatable(L, -2);
+	lua_ent->last_jobs_update = time(NULL);
+
+	lua_setfield(L, -2, "jobs");
+	lua_pop(L, 1);
+}
+#else
+/* Get the list of existing slurmctld job records. Lua 5.1 lacks the __pairs
+ * metamethod, so a proxy table could not be iterated. */
 static void _update_jobs_global(void)
 {
 	char job_id_buf[11]; /* Big enough for a uint32_t */
 	ListIterator iter;
 	struct job_record *job_ptr;
 
-	if (last_lua_jobs_update >= last_job_update) {
+	if (lua_ent->last_jobs_update >= last_job_update) {
 		return;
 	}
 
@@ -440,29 +566,20 @@ static void _update_jobs_global(void)
 		/* Create an empty table, with a metatable that looks up the
 		 * data for the individual job.
 		 */
-		lua_newtable(L);
-
-		lua_newtable(L);
-		lua_pushcfunction(L, _job_rec_field_index);
-		lua_setfield(L, -2, "__index");
-		/* Store the job_record in the metatable, so the index
-		 * function knows which job it's getting data for.
-		 */
-		lua_pushlightuserdata(L, job_ptr);
-		lua_setfield(L, -2, "_job_rec_ptr");
-		lua_setmetatable(L, -2);
+		_push_job_rec(job_ptr);
 
 		/* Lua copies passed strings, so we can reuse the buffer. */
 		snprintf(job_id_buf, sizeof(job_id_buf),
 		         "%d", job_ptr->job_id);
 		lua_setfield(L, -2, job_id_buf);
 	}
-	last_lua_jobs_update = last_job_update;
+	lua_ent->last_jobs_update = last_job_update;
 	list_iterator_destroy(iter);
 
 	lua_setfield(L, -2, "jobs");
 	lua_pop(L, 1);
 }
+#endif
 
 static int _resv_field(const slurmctld_resv_t *resv_ptr,
                        const char *name)
@@ -518,13 +635,113 @@ static int _resv_field_index(lua_State *L)
 	return _resv_field(resv_ptr, name);
 }
 
+static void _push_resv(slurmctld_resv_t *resv_ptr)
+{
+	/* Create an empty table, with a metatable that looks up the
+	 * data for the individual reservation.
+	 */
+	lua_newtable(L);
+
+	lua_newtable(L);
+	lua_pushcfunction(L, _resv_field_index);
+	lua_setfield(L, -2, "__index");
+	/* Store the slurmctld_resv_t in the metatable, so the index
+	 * function knows which reservation it's getting data for.
+	 */
+	lua_pushlightuserdata(L, resv_ptr);
+	lua_setfield(L, -2, "_resv_ptr");
+	lua_setmetatable(L, -2);
+}
+
+#ifndef HAVE_LUA_5_1
+/* Look up a reservation by name for the slurm.reservations proxy table */
+static int _resvs_proxy_index(lua_State *L)
+{
+	slurmctld_resv_t *resv_ptr = NULL;
+	const char *name = lua_tostring(L, 2);
+
+	if (name)
+		resv_ptr = find_resv_name((char *) name);
+	if (!resv_ptr) {
+		lua_pushnil(L);
+		return 1;
+	}
+	_push_resv(resv_ptr);
+
+	return 1;
+}
+
+/* Iterator for pairs(slurm.reservations). Upvalue 1 is an array of the
+ * reservation names which existed when iteration began, upvalue 2 is the
+ * next position in it. */
+static int _resvs_proxy_next(lua_State *L)
+{
+	slurmctld_resv_t *resv_ptr = NULL;
+	int inx = (int) lua_tointeger(L, lua_upvalueindex(2));
+
+	while (!resv_ptr) {
+		lua_rawgeti(L, lua_upvalueindex(1), inx++);
+		if (lua_isnil(L, -1))
+			return 1;
+		resv_ptr = find_resv_name((char *) lua_tostring(L, -1));
+		lua_pop(L, 1);
+	}
+	lua_pushinteger(L, inx);
+	lua_replace(L, lua_upvalueindex(2));
+
+	lua_pushstring(L, resv_ptr->name);
+	_push_resv(resv_ptr);
+
+	return 2;
+}
+
+static int _resvs_proxy_pairs(lua_State *L)
+{
+	ListIterator iter;
+	slurmctld_resv_t *resv_ptr;
+	int inx = 1;
+
+	lua_newtable(L);
+	iter = list_iterator_create(resv_list);
+	while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
+		lua_pushstring(L, resv_ptr->name);
+		lua_rawseti(L, -2, inx++);
+	}
+	list_iterator_destroy(iter);
+	lua_pushinteger(L, 1);
+	lua_pushcclosure(L, _resvs_proxy_next, 2);
+
+	return 1;
+}
+
+/* Install slurm.reservations as a proxy table, see _update_jobs_global() */
+static void _update_resvs_global(void)
+{
+	if (lua_ent->last_resv_update)
+		return;
+
+	lua_getglobal(L, "slurm");
+	lua_newtable(L);
+
+	lua_newtable(L);
+	lua_pushcfunction(L, _resvs_proxy_index);
+	lua_setfield(L, -2, "__index");
+	lua_pushcfunction(L, _resvs_proxy_pairs);
+	lua_setfield(L, -2, "__pairs");
+	lua_setmetatable(L, -2);
+	lua_ent->last_resv_update = time(NULL);
+
+	lua_setfield(L, -2, "reservations");
+	lua_pop(L, 1);
+}
+#else
 /* Get the list of existing slurmctld reservation records. */
 static void _update_resvs_global(void)
 {
 	ListIterator iter;
 	slurmctld_resv_t *resv_ptr;
 
-	if (last_lua_resv_update >= last_resv_update) {
+	if (lua_ent->last_resv_update >= last_resv_update) {
 		return;
 	}
 
@@ -533,29 +750,16 @@ static void _update_resvs_global(void)
 
 	iter = list_iterator_create(resv_list);
 	while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
-		/* Create an empty table, with a metatable that looks up the
-		 * data for the individual reservation.
-		 */
-		lua_newtable(L);
-
-		lua_newtable(L);
-		lua_pushcfunction(L, _resv_field_index);
-		lua_setfield(L, -2, "__index");
-		/* Store the slurmctld_resv_t in the metatable, so the index
-		 * function knows which reservation it's getting data for.
-		 */
-		lua_pushlightuserdata(L, resv_ptr->name);
-		lua_setfield(L, -2, "_resv_ptr");
-		lua_setmetatable(L, -2);
-
+		_push_resv(resv_ptr);
 		lua_setfield(L, -2, resv_ptr->name);
 	}
-	last_lua_resv_update = last_resv_update;
+	lua_ent->last_resv_update = last_resv_update;
 	list_iterator_destroy(iter);
 
 	lua_setfield(L, -2, "reservations");
 	lua_pop(L, 1);
 }
+#endif
 
 /* Set fields in the job request structure on job submit or modify */
 static int _set_job_env_field(lua_State *L)
@@ -1390,9 +1594,9 @@ static void _register_lua_slurm_output_functions (void)
 
 	lua_setglobal (L, "slurm");
 
-	last_lua_jobs_update = 0;
+	lua_ent->last_jobs_update = 0;
 	_update_jobs_global();
-	last_lua_resv_update = 0;
+	lua_ent->last_resv_update = 0;
 	_update_resvs_global();
 }
 
@@ -1449,44 +1653,44 @@ static int _check_lua_script_functions(void)
 	return (rc);
 }
 
-static int _load_script(void)
+/*
+ *  Return true if the script loaded in Lua state L declared itself safe for
+ *  concurrent evaluation with "slurm.thread_safe = true"
+ */
+static bool _script_thread_safe(lua_State *L)
 {
-	int rc = SLURM_SUCCESS;
-	struct stat st;
-	lua_State *L_orig = L;
+	bool thread_safe;
 
-	if (stat(lua_script_path, &st) != 0) {
-		if (L_orig) {
-			(void) error("Unable to stat %s, "
-			             "using old script: %s",
-			             lua_script_path, strerror(errno));
-			return SLURM_SUCCESS;
-		}
-		return error("Unable to stat %s: %s",
-		             lua_script_path, strerror(errno));
-	}
-	
-	if (st.st_mtime <= lua_script_last_loaded) {
-		return SLURM_SUCCESS;
-	}
+	lua_getglobal(L, "slurm");
+	lua_getfield(L, -1, "thread_safe");
+	thread_safe = lua_toboolean(L, -1);
+	lua_pop(L, 2);
+
+	return thread_safe;
+}
+
+/*
+ *  Load the job_submit/lua script into a new Lua state
+ *  OUT ent - pool entry to hold the new state, left empty on failure
+ *  IN have_old - true if a previously loaded script remains in use
+ */
+static int _load_state(lua_pool_ent_t *ent, bool have_old)
+{
+	int rc;
+	const char *old_msg = have_old ? ", using previous script" : "";
+
+	memset(ent, 0, sizeof(lua_pool_ent_t));
+	lua_ent = ent;
 
 	/*
 	 *  Initilize lua
 	 */
-	L = luaL_newstate();
+	L = ent->L = luaL_newstate();
 	luaL_openlibs(L);
 	if (luaL_loadfile(L, lua_script_path)) {
-		if (L_orig) {
-			(void) error("lua: %s: %s, using previous script",
-			             lua_script_path, lua_tostring(L, -1));
-			lua_close(L);
-			L = L_orig;
-			return SLURM_SUCCESS;
-		}
-		rc = error("lua: %s: %s", lua_script_path,
-		           lua_tostring(L, -1));
-		lua_pop(L, 1);
-		return rc;
+		rc = error("lua: %s: %s%s", lua_script_path,
+			   lua_tostring(L, -1), old_msg);
+		goto fail;
 	}
 
 	/*
@@ -1500,66 +1704,167 @@ static int _load_script(void)
 	 *  Run the user script:
 	 */
 	if (lua_pcall(L, 0, 1, 0) != 0) {
-		if (L_orig) {
-			(void) error("job_submit/lua: %s: %s, "
-			             "using previous script",
-			             lua_script_path, lua_tostring(L, -1));
-			lua_close(L);
-			L = L_orig;
-			return SLURM_SUCCESS;
-		}
-		rc = error("job_submit/lua: %s: %s",
-		           lua_script_path, lua_tostring(L, -1));
-		lua_pop(L, 1);
-		return rc;
+		rc = error("job_submit/lua: %s: %s%s", lua_script_path,
+			   lua_tostring(L, -1), old_msg);
+		goto fail;
 	}
 
 	/*
 	 *  Get any return code from the lua script
 	 */
 	rc = (int) lua_tonumber(L, -1);
+	lua_pop(L, 1);
 	if (rc != SLURM_SUCCESS) {
-		if (L_orig) {
-			(void) error("job_submit/lua: %s: returned %d "
-			             "on load, using previous script",
-			             lua_script_path, rc);
-			lua_close(L);
-			L = L_orig;
-			return SLURM_SUCCESS;
-		}
-		(void) error("job_submit/lua: %s: returned %d on load",
-		             lua_script_path, rc);
-		lua_pop (L, 1);
-		return rc;
+		(void) error("job_submit/lua: %s: returned %d on load%s",
+			     lua_script_path, rc, old_msg);
+		goto fail;
 	}
 
 	/*
 	 *  Check for required lua script functions:
 	 */
 	rc = _check_lua_script_functions();
-	if (rc != SLURM_SUCCESS) {
-		if (L_orig) {
-			(void) error("job_submit/lua: %s: "
-			             "required function(s) not present, "
-			             "using previous script",
-			             lua_script_path);
-			lua_close(L);
-			L = L_orig;
+	if (rc != SLURM_SUCCESS)
+		goto fail;
+
+	L = NULL;
+	lua_ent = NULL;
+	return SLURM_SUCCESS;
+
+fail:	lua_close(ent->L);
+	ent->L = NULL;
+	L = NULL;
+	lua_ent = NULL;
+	return rc;
+}
+
+static void _log_hist(const char *name, uint32_t *hist)
+{
+	int i;
+	uint32_t total = 0;
+
+	for (i = 0; i < LUA_HIST_BUCKETS; i++)
+		total += hist[i];
+	if (total == 0)
+		return;
+
+	verbose("job_submit/lua: %s calls:%u usec <%ld:%u <%ld:%u <%ld:%u "
+		"<%ld:%u <%ld:%u >=%ld:%u", name, total,
+		lua_hist_limit[0], hist[0], lua_hist_limit[1], hist[1],
+		lua_hist_limit[2], hist[2], lua_hist_limit[3], hist[3],
+		lua_hist_limit[4], hist[4], lua_hist_limit[4], hist[5]);
+}
+
+/*
+ *  (Re)load the script into the pool of Lua states if it has changed.
+ *  Caller must hold lua_lock.
+ */
+static int _load_script(void)
+{
+	int i, pool_size, rc = SLURM_SUCCESS;
+	struct stat st;
+	lua_pool_ent_t new_ent;
+
+	if (stat(lua_script_path, &st) != 0) {
+		if (lua_pool_cnt) {
+			(void) error("Unable to stat %s, "
+			             "using old script: %s",
+			             lua_script_path, strerror(errno));
 			return SLURM_SUCCESS;
 		}
+		return error("Unable to stat %s: %s",
+		             lua_script_path, strerror(errno));
+	}
+
+	if (st.st_mtime <= lua_script_last_loaded) {
+		return SLURM_SUCCESS;
+	}
+
+	/* All states are replaced together, wait for running calls */
+	while (lua_pool_busy)
+		slurm_cond_wait(&lua_pool_cond, &lua_lock);
+	if (st.st_mtime <= lua_script_last_loaded)
+		return SLURM_SUCCESS;	/* Reloaded by another thread */
+
+	rc = _load_state(&new_ent, (lua_pool_cnt > 0));
+	if (rc != SLURM_SUCCESS) {
+		if (lua_pool_cnt)
+			return SLURM_SUCCESS;
 		return rc;
 	}
 
-	if (L_orig)
-		lua_close(L_orig);
+	_log_hist("job_submit", lua_hist_submit);
+	_log_hist("job_modify", lua_hist_modify);
+	for (i = 0; i < lua_pool_cnt; i++)
+		lua_close(lua_pool[i].L);
+	lua_pool[0] = new_ent;
+	lua_pool_cnt = 1;
+
+	pool_size = _script_thread_safe(new_ent.L) ? LUA_POOL_SIZE : 1;
+	while (lua_pool_cnt < pool_size) {
+		if (_load_state(&lua_pool[lua_pool_cnt], true) !=
+		    SLURM_SUCCESS)
+			break;
+		lua_pool_cnt++;
+	}
+	if (pool_size > 1) {
+		verbose("job_submit/lua: %s is thread safe, loaded into %d "
+			"Lua states", lua_script_path, lua_pool_cnt);
+	}
+
 	lua_script_last_loaded = time(NULL);
 	return SLURM_SUCCESS;
 }
 
+/*
+ *  Take an idle Lua state from the pool for use by this thread, waiting for
+ *  one if all are busy. Caller must hold lua_lock.
+ */
+static lua_pool_ent_t *_pool_acquire(void)
+{
+	int i;
+
+	while (lua_pool_cnt) {
+		for (i = 0; i < lua_pool_cnt; i++) {
+			if (lua_pool[i].in_use)
+				continue;
+			lua_pool[i].in_use = true;
+			lua_pool_busy++;
+			lua_ent = &lua_pool[i];
+			L = lua_ent->L;
+			return lua_ent;
+		}
+		slurm_cond_wait(&lua_pool_cond, &lua_lock);
+	}
+
+	return NULL;
+}
+
+/*
+ *  Return this thread's Lua state to the pool and record the call latency.
+ *  Caller must hold lua_lock.
+ */
+static void _pool_release(uint32_t *hist, long usec)
+{
+	int i;
+
+	for (i = 0; i < (LUA_HIST_BUCKETS - 1); i++) {
+		if (usec < lua_hist_limit[i])
+			break;
+	}
+	hist[i]++;
+
+	lua_ent->in_use = false;
+	lua_pool_busy--;
+	lua_ent = NULL;
+	L = NULL;
+	slurm_cond_broadcast(&lua_pool_cond);
+}
+
 /*
  *  NOTE: The init callback should never be called multiple times,
- *   let alone called from multiple threads. Therefore, locking
- *   is unnecessary here.
+ *   let alone called from multiple threads. lua_lock is only taken
+ *   here to satisfy _load_script().
  */
 int init(void)
 {
@@ -1572,12 +1877,24 @@ int init(void)
 	if ((rc = xlua_dlopen()) != SLURM_SUCCESS)
 		return rc;
 
-	return _load_script();
+	slurm_mutex_lock (&lua_lock);
+	rc = _load_script();
+	slurm_mutex_unlock (&lua_lock);
+
+	return rc;
 }
 
 int fini(void)
 {
-	lua_close (L);
+	int i;
+
+	_log_hist("job_submit", lua_hist_submit);
+	_log_hist("job_modify", lua_hist_modify);
+	for (i = 0; i < lua_pool_cnt; i++)
+		lua_close(lua_pool[i].L);
+	memset(lua_pool, 0, sizeof(lua_pool));
+	lua_pool_cnt = 0;
+	lua_script_last_loaded = (time_t) 0;
 	return SLURM_SUCCESS;
 }
 
@@ -1586,10 +1903,17 @@ int fini(void)
 extern int job_submit(struct job_descriptor *job_desc, uint32_t submit_uid,
 		      char **err_msg)
 {
+	DEF_TIMERS;
 	int rc = SLURM_ERROR;
-	slurm_mutex_lock (&lua_lock);
 
+	START_TIMER;
+	slurm_mutex_lock (&lua_lock);
 	(void) _load_script();
+	if (!_pool_acquire()) {
+		slurm_mutex_unlock (&lua_lock);
+		return rc;
+	}
+	slurm_mutex_unlock (&lua_lock);
 
 	/*
 	 *  All lua script functions should have been verified during
@@ -1628,7 +1952,10 @@ extern int job_submit(struct job_descriptor *job_desc, uint32_t submit_uid,
 			xfree(user_msg);
 	}
 
-out:	slurm_mutex_unlock (&lua_lock);
+out:	END_TIMER;
+	slurm_mutex_lock (&lua_lock);
+	_pool_release(lua_hist_submit, DELTA_TIMER);
+	slurm_mutex_unlock (&lua_lock);
 	return rc;
 }
 
@@ -1636,8 +1963,16 @@ out:	slurm_mutex_unlock (&lua_lock);
 extern int job_modify(struct job_descriptor *job_desc,
 		      struct job_record *job_ptr, uint32_t submit_uid)
 {
+	DEF_TIMERS;
 	int rc = SLURM_ERROR;
+
+	START_TIMER;
 	slurm_mutex_lock (&lua_lock);
+	if (!_pool_acquire()) {
+		slurm_mutex_unlock (&lua_lock);
+		return rc;
+	}
+	slurm_mutex_unlock (&lua_lock);
 
 	/*
 	 *  All lua script functions should have been verified during
@@ -1670,6 +2005,9 @@ extern int job_modify(struct job_descriptor *job_desc,
 	}
 	_stack_dump("job_modify, after lua_pcall", L);
 
-out:	slurm_mutex_unlock (&lua_lock);
+out:	END_TIMER;
+	slurm_mutex_lock (&lua_lock);
+	_pool_release(lua_hist_modify, DELTA_TIMER);
+	slurm_mutex_unlock (&lua_lock);
 	return rc;
 }
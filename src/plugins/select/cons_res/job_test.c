@@ -1999,6 +1999,172 @@ static int _eval_nodes_serial(struct job_record *job_ptr, bitstr_t *node_map,
 fini:	return error_code;
 }
 
+/*
+ * Cached switch membership used by the topology aware node selection.
+ * For every node, the indexes of all switches whose node_bitmap contains it
+ * (typically one switch per level of the tree). This lets the per-switch node
+ * and CPU counts available to a job be accumulated with one walk over the
+ * job's usable nodes, instead of copying and intersecting every switch's
+ * node_bitmap with the job's bitmap on each evaluation. Per-switch bitmaps are
+ * then only built for the switches actually picked.
+ */
+static bool       topo_cache_built  = false;
+static uint32_t   topo_node_cnt     = 0;
+static int        topo_switch_cnt   = 0;
+static uint32_t  *topo_node_offset  = NULL;  /* node's first topo_node_switch */
+static uint16_t  *topo_node_switch  = NULL;  /* switches containing nodes */
+static bitstr_t  *topo_switch_nodes = NULL;  /* nodes on any switch */
+static bitstr_t **topo_leaf_subset  = NULL;  /* leafs fully within switch */
+static bitstr_t **topo_leaf_partial = NULL;  /* leafs partly within switch */
+
+/* Free the cached switch membership, rebuilt on next use */
+extern void cr_topo_cache_fini(void)
+{
+	int i;
+
+	if (topo_leaf_subset) {
+		for (i = 0; i < topo_switch_cnt; i++) {
+			FREE_NULL_BITMAP(topo_leaf_subset[i]);
+			FREE_NULL_BITMAP(topo_leaf_partial[i]);
+		}
+	}
+	xfree(topo_leaf_subset);
+	xfree(topo_leaf_partial);
+	xfree(topo_node_offset);
+	xfree(topo_node_switch);
+	FREE_NULL_BITMAP(topo_switch_nodes);
+	topo_node_cnt = 0;
+	topo_switch_cnt = 0;
+	topo_cache_built = false;
+}
+
+static void _topo_cache_build(uint32_t cr_node_cnt)
+{
+	uint32_t *node_fill;
+	int i, j, first, last;
+
+	if (topo_cache_built && (topo_node_cnt == cr_node_cnt) &&
+	    (topo_switch_cnt == switch_record_cnt))
+		return;
+	cr_topo_cache_fini();
+
+	topo_node_cnt = cr_node_cnt;
+	topo_switch_cnt = switch_record_cnt;
+	topo_node_offset  = xmalloc(sizeof(uint32_t) * (cr_node_cnt + 1));
+	topo_switch_nodes = bit_alloc(cr_node_cnt);
+	topo_leaf_subset  = xmalloc(sizeof(bitstr_t *) * switch_record_cnt);
+	topo_leaf_partial = xmalloc(sizeof(bitstr_t *) * switch_record_cnt);
+
+	/* Count switches per node, then convert counts to offsets */
+	for (j = 0; j < switch_record_cnt; j++) {
+		first = bit_ffs(switch_record_table[j].node_bitmap);
+		if (first < 0)
+			continue;
+		last = bit_fls(switch_record_table[j].node_bitmap);
+		for (i = first; (i <= last) && (i < cr_node_cnt); i++) {
+			if (bit_test(switch_record_table[j].node_bitmap, i))
+				topo_node_offset[i + 1]++;
+		}
+		bit_or(topo_switch_nodes, switch_record_table[j].node_bitmap);
+	}
+	for (i = 0; i < cr_node_cnt; i++)
+		topo_node_offset[i + 1] += topo_node_offset[i];
+
+	topo_node_switch = xmalloc(sizeof(uint16_t) *
+				   MAX(topo_node_offset[cr_node_cnt], 1));
+	node_fill = xmalloc(sizeof(uint32_t) * cr_node_cnt);
+	memcpy(node_fill, topo_node_offset, sizeof(uint32_t) * cr_node_cnt);
+	for (j = 0; j < switch_record_cnt; j++) {
+		first = bit_ffs(switch_record_table[j].node_bitmap);
+		if (first < 0)
+			continue;
+		last = bit_fls(switch_record_table[j].node_bitmap);
+		for (i = first; (i <= last) && (i < cr_node_cnt); i++) {
+			if (bit_test(switch_record_table[j].node_bitmap, i))
+				topo_node_switch[node_fill[i]++] = j;
+		}
+	}
+	xfree(node_fill);
+	topo_cache_built = true;
+}
+
+/*
+ * Accumulate the nodes and CPUs available on each switch from the usable
+ * nodes in bitmap. Returns a bitmap of the usable nodes on any switch.
+ */
+static bitstr_t *_topo_switch_counts(bitstr_t *bitmap, uint32_t cr_node_cnt,
+				     uint16_t *cpu_cnt, int *switches_node_cnt,
+				     int *switches_cpu_cnt)
+{
+	bitstr_t *avail_nodes_bitmap;
+	uint32_t k;
+	int i, first, last;
+
+	_topo_cache_build(cr_node_cnt);
+	avail_nodes_bitmap = bit_copy(bitmap);
+	bit_and(avail_nodes_bitmap, topo_switch_nodes);
+
+	first = bit_ffs(avail_nodes_bitmap);
+	if (first < 0)
+		return avail_nodes_bitmap;
+	last = bit_fls(avail_nodes_bitmap);
+	for (i = first; i <= last; i++) {
+		if (!bit_test(avail_nodes_bitmap, i))
+			continue;
+		for (k = topo_node_offset[i]; k < topo_node_offset[i + 1];
+		     k++) {
+			switches_node_cnt[topo_node_switch[k]]++;
+			switches_cpu_cnt[topo_node_switch[k]] += cpu_cnt[i];
+		}
+	}
+	return avail_nodes_bitmap;
+}
+
+/* Return the usable nodes on switch sw, building the bitmap on first use */
+static bitstr_t *_topo_switch_bitmap(bitstr_t **switches_bitmap, int sw,
+				     bitstr_t *usable_bitmap)
+{
+	if (!switches_bitmap[sw]) {
+		switches_bitmap[sw] = bit_copy(switch_record_table[sw].
+					       node_bitmap);
+		bit_and(switches_bitmap[sw], usable_bitmap);
+	}
+	return switches_bitmap[sw];
+}
+
+/*
+ * Return true if the usable nodes on leaf switch leaf are a subset of those on
+ * switch sw. Only called for leafs with usable nodes.
+ */
+static bool _topo_leaf_within(bitstr_t **switches_bitmap, int leaf, int sw,
+			      bitstr_t *usable_bitmap)
+{
+	int j;
+
+	if (!topo_leaf_subset[sw]) {
+		topo_leaf_subset[sw]  = bit_alloc(switch_record_cnt);
+		topo_leaf_partial[sw] = bit_alloc(switch_record_cnt);
+		for (j = 0; j < switch_record_cnt; j++) {
+			if (switch_record_table[j].level != 0)
+				continue;
+			if (bit_super_set(switch_record_table[j].node_bitmap,
+					  switch_record_table[sw].node_bitmap))
+				bit_set(topo_leaf_subset[sw], j);
+			else if (bit_overlap(switch_record_table[j].node_bitmap,
+					     switch_record_table[sw].
+					     node_bitmap))
+				bit_set(topo_leaf_partial[sw], j);
+		}
+	}
+	if (bit_test(topo_leaf_subset[sw], leaf))
+		return true;
+	if (!bit_test(topo_leaf_partial[sw], leaf))
+		return false;
+	return bit_super_set(
+		_topo_switch_bitmap(switches_bitmap, leaf, usable_bitmap),
+		_topo_switch_bitmap(switches_bitmap, sw, usable_bitmap));
+}
+
 /*
  * A network topology aware version of _eval_nodes().
  * NOTE: The logic here is almost identical to that of _job_test_topo()
@@ -2017,6 +2183,8 @@ static int _eval_nodes_topo(struct job_record *job_ptr, bitstr_t *bitmap,
 
 	bitstr_t  *avail_nodes_bitmap = NULL;	/* nodes on any switch */
 	bitstr_t  *req_nodes_bitmap   = NULL;
+	bitstr_t  *usable_bitmap      = NULL;	/* set if switches_bitmap
+						 * built on demand */
 	int rem_cpus, rem_nodes;	/* remaining resources desired */
 	int min_rem_nodes;	/* remaining resources desired */
 	int avail_cpus;
@@ -2058,16 +2226,24 @@ static int _eval_nodes_topo(struct job_record *job_ptr, bitstr_t *bitmap,
 	switches_cpu_cnt  = xmalloc(sizeof(int)        * switch_record_cnt);
 	switches_node_cnt = xmalloc(sizeof(int)        * switch_record_cnt);
 	switches_required = xmalloc(sizeof(int)        * switch_record_cnt);
-	avail_nodes_bitmap = bit_alloc(cr_node_cnt);
-	for (i=0; i<switch_record_cnt; i++) {
-		switches_bitmap[i] = bit_copy(switch_record_table[i].
-					      node_bitmap);
-		bit_and(switches_bitmap[i], bitmap);
-		bit_or(avail_nodes_bitmap, switches_bitmap[i]);
-		switches_node_cnt[i] = bit_set_count(switches_bitmap[i]);
-		if (req_nodes_bitmap &&
-		    bit_overlap(req_nodes_bitmap, switches_bitmap[i])) {
-			switches_required[i] = 1;
+	if (!req_nodes_bitmap) {
+		usable_bitmap = bit_copy(bitmap);
+		avail_nodes_bitmap = _topo_switch_counts(usable_bitmap,
+							 cr_node_cnt, cpu_cnt,
+							 switches_node_cnt,
+							 switches_cpu_cnt);
+	} else {
+		avail_nodes_bitmap = bit_alloc(cr_node_cnt);
+		for (i=0; i<switch_record_cnt; i++) {
+			switches_bitmap[i] = bit_copy(switch_record_table[i].
+						      node_bitmap);
+			bit_and(switches_bitmap[i], bitmap);
+			bit_or(avail_nodes_bitmap, switches_bitmap[i]);
+			switches_node_cnt[i] =
+				bit_set_count(switches_bitmap[i]);
+			if (bit_overlap(req_nodes_bitmap,
+					switches_bitmap[i]))
+				switches_required[i] = 1;
 		}
 	}
 	bit_nclear(bitmap, 0, cr_node_cnt - 1);
@@ -2077,7 +2253,8 @@ static int _eval_nodes_topo(struct job_record *job_ptr, bitstr_t *bitmap,
 			char *node_names = NULL;
 			if (switches_node_cnt[i]) {
 				node_names = bitmap2node_name(
-						switches_bitmap[i]);
+					_topo_switch_bitmap(switches_bitmap, i,
+							    usable_bitmap));
 			}
 			info("switch=%s level=%d nodes=%u:%s required:%u speed:%u",
 			     switch_record_table[i].name,
@@ -2181,7 +2358,7 @@ static int _eval_nodes_topo(struct job_record *job_ptr, bitstr_t *bitmap,
 				}
 			}
 		}
-	} else {
+	} else if (!usable_bitmap) {
 		/* No specific required nodes, calculate CPU counts */
 		for (j=0; j<switch_record_cnt; j++) {
 			first = bit_ffs(switches_bitmap[j]);
@@ -2258,13 +2435,21 @@ static int _eval_nodes_topo(struct job_record *job_ptr, bitstr_t *bitmap,
 		rc = SLURM_ERROR;
 		goto fini;
 	}
-	bit_and(avail_nodes_bitmap, switches_bitmap[best_fit_inx]);
+	bit_and(avail_nodes_bitmap,
+		_topo_switch_bitmap(switches_bitmap, best_fit_inx,
+				    usable_bitmap));
 
 	/* Identify usable leafs (within higher switch having best fit) */
-	for (j=0; j<switch_record_cnt; j++) {
-		if ((switch_record_table[j].level != 0) ||
-		    (!bit_super_set(switches_bitmap[j],
-				    switches_bitmap[best_fit_inx]))) {
+	for (j = 0; j < switch_record_cnt; j++) {
+		if (switch_record_table[j].level != 0) {
+			switches_node_cnt[j] = 0;
+		} else if (usable_bitmap) {
+			if (switches_node_cnt[j] &&
+			    !_topo_leaf_within(switches_bitmap, j,
+					       best_fit_inx, usable_bitmap))
+				switches_node_cnt[j] = 0;
+		} else if (!bit_super_set(switches_bitmap[j],
+					  switches_bitmap[best_fit_inx])) {
 			switches_node_cnt[j] = 0;
 		}
 	}
@@ -2325,6 +2510,8 @@ static int _eval_nodes_topo(struct job_record *job_ptr, bitstr_t *bitmap,
 
 		leaf_switch_count++;
 		/* Use select nodes from this leaf */
+		_topo_switch_bitmap(switches_bitmap, best_fit_location,
+				    usable_bitmap);
 		first = bit_ffs(switches_bitmap[best_fit_location]);
 		last  = bit_fls(switches_bitmap[best_fit_location]);
 
@@ -2441,6 +2628,7 @@ static int _eval_nodes_topo(struct job_record *job_ptr, bitstr_t *bitmap,
 
  fini:	FREE_NULL_BITMAP(avail_nodes_bitmap);
 	FREE_NULL_BITMAP(req_nodes_bitmap);
+	FREE_NULL_BITMAP(usable_bitmap);
 	if (switches_bitmap) {
 		for (i = 0; i < switch_record_cnt; i++) {
 			FREE_NULL_BITMAP(switches_bitmap[i]);
@@ -2472,6 +2660,8 @@ static int _eval_nodes_dfly(struct job_record *job_ptr, bitstr_t *bitmap,
 
 	bitstr_t  *avail_nodes_bitmap = NULL;	/* nodes on any switch */
 	bitstr_t  *req_nodes_bitmap   = NULL;
+	bitstr_t  *usable_bitmap      = NULL;	/* set if switches_bitmap
+						 * built on demand */
 	int rem_cpus, rem_nodes;	/* remaining resources desired */
 	int min_rem_nodes;	/* remaining resources desired */
 	int avail_cpus;
@@ -2520,13 +2710,22 @@ static int _eval_nodes_dfly(struct job_record *job_ptr, bitstr_t *bitmap,
 	switches_cpu_cnt  = xmalloc(sizeof(int)        * switch_record_cnt);
 	switches_node_cnt = xmalloc(sizeof(int)        * switch_record_cnt);
 	switches_node_use = xmalloc(sizeof(int)        * switch_record_cnt);
-	avail_nodes_bitmap = bit_alloc(cr_node_cnt);
-	for (i = 0; i < switch_record_cnt; i++) {
-		switches_bitmap[i] = bit_copy(switch_record_table[i].
-					      node_bitmap);
-		bit_and(switches_bitmap[i], bitmap);
-		bit_or(avail_nodes_bitmap, switches_bitmap[i]);
-		switches_node_cnt[i] = bit_set_count(switches_bitmap[i]);
+	if (!req_nodes_bitmap) {
+		usable_bitmap = bit_copy(bitmap);
+		avail_nodes_bitmap = _topo_switch_counts(usable_bitmap,
+							 cr_node_cnt, cpu_cnt,
+							 switches_node_cnt,
+							 switches_cpu_cnt);
+	} else {
+		avail_nodes_bitmap = bit_alloc(cr_node_cnt);
+		for (i = 0; i < switch_record_cnt; i++) {
+			switches_bitmap[i] = bit_copy(switch_record_table[i].
+						      node_bitmap);
+			bit_and(switches_bitmap[i], bitmap);
+			bit_or(avail_nodes_bitmap, switches_bitmap[i]);
+			switches_node_cnt[i] =
+				bit_set_count(switches_bitmap[i]);
+		}
 	}
 	bit_nclear(bitmap, 0, cr_node_cnt - 1);
 
@@ -2535,7 +2734,8 @@ static int _eval_nodes_dfly(struct job_record *job_ptr, bitstr_t *bitmap,
 			char *node_names = NULL;
 			if (switches_node_cnt[i]) {
 				node_names = bitmap2node_name(
-						switches_bitmap[i]);
+					_topo_switch_bitmap(switches_bitmap, i,
+							    usable_bitmap));
 			}
 			debug("switch=%s nodes=%u:%s speed:%u",
 			      switch_record_table[i].name,
@@ -2640,7 +2840,7 @@ static int _eval_nodes_dfly(struct job_record *job_ptr, bitstr_t *bitmap,
 				}
 			}
 		}
-	} else {
+	} else if (!usable_bitmap) {
 		/* No specific required nodes, calculate CPU counts */
 		for (j = 0; j < switch_record_cnt; j++) {
 			first = bit_ffs(switches_bitmap[j]);
@@ -2700,13 +2900,21 @@ static int _eval_nodes_dfly(struct job_record *job_ptr, bitstr_t *bitmap,
 		rc = SLURM_ERROR;
 		goto fini;
 	}
-	bit_and(avail_nodes_bitmap, switches_bitmap[best_fit_inx]);
+	bit_and(avail_nodes_bitmap,
+		_topo_switch_bitmap(switches_bitmap, best_fit_inx,
+				    usable_bitmap));
 
 	/* Identify usable leafs (within higher switch having best fit) */
 	for (j = 0; j < switch_record_cnt; j++) {
-		if ((switch_record_table[j].level != 0) ||
-		    (!bit_super_set(switches_bitmap[j],
-				    switches_bitmap[best_fit_inx]))) {
+		if (switch_record_table[j].level != 0) {
+			switches_node_cnt[j] = 0;
+		} else if (usable_bitmap) {
+			if (switches_node_cnt[j] &&
+			    !_topo_leaf_within(switches_bitmap, j,
+					       best_fit_inx, usable_bitmap))
+				switches_node_cnt[j] = 0;
+		} else if (!bit_super_set(switches_bitmap[j],
+					  switches_bitmap[best_fit_inx])) {
 			switches_node_cnt[j] = 0;
 		}
 	}
@@ -2739,6 +2947,8 @@ static int _eval_nodes_dfly(struct job_record *job_ptr, bitstr_t *bitmap,
 			break;
 
 		/* Use select nodes from this leaf */
+		_topo_switch_bitmap(switches_bitmap, best_fit_location,
+				    usable_bitmap);
 		first = bit_ffs(switches_bitmap[best_fit_location]);
 		last  = bit_fls(switches_bitmap[best_fit_location]);
 
@@ -2853,6 +3063,7 @@ static int _eval_nodes_dfly(struct job_record *job_ptr, bitstr_t *bitmap,
 
  fini:	FREE_NULL_BITMAP(avail_nodes_bitmap);
 	FREE_NULL_BITMAP(req_nodes_bitmap);
+	FREE_NULL_BITMAP(usable_bitmap);
 	if (switches_bitmap) {
 		for (i = 0; i < switch_record_cnt; i++) {
 			FREE_NULL_BITMAP(switches_bitmap[i]);
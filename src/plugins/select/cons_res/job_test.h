@@ -78,4 +78,10 @@ int cr_job_test(struct job_record *job_ptr, bitstr_t *node_bitmap,
  */
 extern bitstr_t *make_core_bitmap(bitstr_t *node_map, uint16_t core_spec);
 
+/*
+ * Free the cached node to switch membership used by topology aware node
+ * selection. Call whenever the node or switch tables change.
+ */
+extern void cr_topo_cache_fini(void);
+
 #endif /* !_CR_JOB_TEST_H */
@@ -310,7 +310,7 @@ static void _dump_state(struct part_res_record *p_ptr)
 	return;
 }
 
-/* Helper function for _dup_part_data: create a duplicate part_row_data array */
+/* Create a duplicate part_row_data array */
 static struct part_row_data *_dup_row_data(struct part_row_data *orig_row,
 					   uint16_t num_rows)
 {
@@ -339,57 +339,6 @@ static struct part_row_data *_dup_row_data(struct part_row_data *orig_row,
 }
 
 
-/* Create a duplicate part_res_record list */
-static struct part_res_record *_dup_part_data(struct part_res_record *orig_ptr)
-{
-	struct part_res_record *new_part_ptr, *new_ptr;
-
-	if (orig_ptr == NULL)
-		return NULL;
-
-	new_part_ptr = xmalloc(sizeof(struct part_res_record));
-	new_ptr = new_part_ptr;
-
-	while (orig_ptr) {
-		new_ptr->part_ptr = orig_ptr->part_ptr;
-		new_ptr->num_rows = orig_ptr->num_rows;
-		new_ptr->row = _dup_row_data(orig_ptr->row,
-					     orig_ptr->num_rows);
-		if (orig_ptr->next) {
-			new_ptr->next = xmalloc(sizeof(struct part_res_record));
-			new_ptr = new_ptr->next;
-		}
-		orig_ptr = orig_ptr->next;
-	}
-	return new_part_ptr;
-}
-
-
-/* Create a duplicate part_res_record list */
-static struct node_use_record *_dup_node_usage(struct node_use_record *orig_ptr)
-{
-	struct node_use_record *new_use_ptr, *new_ptr;
-	List gres_list;
-	uint32_t i;
-
-	if (orig_ptr == NULL)
-		return NULL;
-
-	new_use_ptr = xmalloc(select_node_cnt * sizeof(struct node_use_record));
-	new_ptr = new_use_ptr;
-
-	for (i = 0; i < select_node_cnt; i++) {
-		new_ptr[i].node_state   = orig_ptr[i].node_state;
-		new_ptr[i].alloc_memory = orig_ptr[i].alloc_memory;
-		if (orig_ptr[i].gres_list)
-			gres_list = orig_ptr[i].gres_list;
-		else
-			gres_list = node_record_table_ptr[i].gres_list;
-		new_ptr[i].gres_list = gres_plugin_node_state_dup(gres_list);
-	}
-	return new_use_ptr;
-}
-
 /* delete the given row data */
 static void _destroy_row_data(struct part_row_data *row, uint16_t num_rows) {
 	uint16_t i;
@@ -486,6 +435,180 @@ static void _destroy_node_data(struct node_use_record *node_usage,
 	}
 }
 
+/*
+ * What-if simulation support for preemption and will-run tests.
+ *
+ * Rather than duplicating the row data of every partition and the GRES state
+ * of every node before simulating the removal of running jobs, a simulation
+ * shares the live records and copies an entry only when a hypothetical job
+ * removal is about to modify it. The original value is kept in an undo log,
+ * so a simulation can be rolled back to the live state (and reused) at a cost
+ * proportional to the number of entries actually modified.
+ */
+/* Start a what-if simulation of the current select_part_record and
+ * select_node_usage state. Release with _sim_end() */
+static struct cr_sim *_sim_begin(void)
+{
+	struct cr_sim *sim;
+	struct part_res_record *orig_ptr, *new_ptr = NULL;
+
+	if (!select_part_record || !select_node_usage)
+		return NULL;
+
+	sim = xmalloc(sizeof(struct cr_sim));
+	for (orig_ptr = select_part_record; orig_ptr;
+	     orig_ptr = orig_ptr->next) {
+		if (new_ptr) {
+			new_ptr->next = xmalloc(sizeof(struct part_res_record));
+			new_ptr = new_ptr->next;
+		} else {
+			sim->part = xmalloc(sizeof(struct part_res_record));
+			new_ptr = sim->part;
+		}
+		new_ptr->part_ptr = orig_ptr->part_ptr;
+		new_ptr->num_rows = orig_ptr->num_rows;
+		new_ptr->row      = orig_ptr->row;	/* copied on write */
+	}
+	sim->usage = xmalloc(select_node_cnt * sizeof(struct node_use_record));
+	memcpy(sim->usage, select_node_usage,
+	       select_node_cnt * sizeof(struct node_use_record));
+	sim->node_logged = bit_alloc(select_node_cnt);
+
+	return sim;
+}
+
+/* Give a simulated node a private copy of its usage record before change */
+static void _sim_log_node(struct cr_sim *sim, int node_inx)
+{
+	struct sim_node_undo *undo;
+	List gres_list;
+
+	if (bit_test(sim->node_logged, node_inx))
+		return;
+	bit_set(sim->node_logged, node_inx);
+
+	if (sim->node_undo_cnt >= sim->node_undo_size) {
+		sim->node_undo_size += 64;
+		xrealloc(sim->node_undo, sim->node_undo_size *
+			 sizeof(struct sim_node_undo));
+	}
+	undo = &sim->node_undo[sim->node_undo_cnt++];
+	undo->node_inx = node_inx;
+	undo->orig = sim->usage[node_inx];
+
+	if (undo->orig.gres_list)
+		gres_list = undo->orig.gres_list;
+	else
+		gres_list = node_record_table_ptr[node_inx].gres_list;
+	sim->usage[node_inx].gres_list = gres_plugin_node_state_dup(gres_list);
+}
+
+/* Give a simulated partition a private copy of its rows before change */
+static void _sim_log_part(struct cr_sim *sim, struct part_res_record *p_ptr)
+{
+	struct sim_part_undo *undo;
+	int i;
+
+	if (!p_ptr->row)
+		return;
+	for (i = 0; i < sim->part_undo_cnt; i++) {
+		if (sim->part_undo[i].p_ptr == p_ptr)
+			return;
+	}
+
+	if (sim->part_undo_cnt >= sim->part_undo_size) {
+		sim->part_undo_size += 8;
+		xrealloc(sim->part_undo, sim->part_undo_size *
+			 sizeof(struct sim_part_undo));
+	}
+	undo = &sim->part_undo[sim->part_undo_cnt++];
+	undo->p_ptr = p_ptr;
+	undo->orig_row = p_ptr->row;
+	p_ptr->row = _dup_row_data(p_ptr->row, p_ptr->num_rows);
+}
+
+/* Hypothetically remove a job's resources from a simulation, see
+ * _rm_job_from_res() for a description of action */
+static int _sim_rm_job(struct cr_sim *sim, struct job_record *job_ptr,
+		       int action)
+{
+	struct job_resources *job = job_ptr->job_resrcs;
+	struct part_res_record *p_ptr;
+	int i, i_first, i_last, n;
+
+	if (job && job->node_bitmap && job->cpus) {
+		i_first = bit_ffs(job->node_bitmap);
+		if (i_first == -1)
+			i_last = -2;
+		else
+			i_last = bit_fls(job->node_bitmap);
+		for (i = i_first, n = -1; i <= i_last; i++) {
+			if (!bit_test(job->node_bitmap, i))
+				continue;
+			n++;
+			if (job->cpus[n] == 0)
+				continue;  /* node lost by job resize */
+			_sim_log_node(sim, i);
+		}
+	}
+	if ((action != 1) && job_ptr->part_ptr) {
+		for (p_ptr = sim->part; p_ptr; p_ptr = p_ptr->next) {
+			if (p_ptr->part_ptr == job_ptr->part_ptr) {
+				_sim_log_part(sim, p_ptr);
+				break;
+			}
+		}
+	}
+
+	return _rm_job_from_res(sim->part, sim->usage, job_ptr, action);
+}
+
+/* Undo all job removals, restoring the simulation to the live state */
+static void _sim_rollback(struct cr_sim *sim)
+{
+	struct sim_node_undo *node_undo;
+	struct sim_part_undo *part_undo;
+	int i;
+
+	for (i = 0; i < sim->node_undo_cnt; i++) {
+		node_undo = &sim->node_undo[i];
+		FREE_NULL_LIST(sim->usage[node_undo->node_inx].gres_list);
+		sim->usage[node_undo->node_inx] = node_undo->orig;
+		bit_clear(sim->node_logged, node_undo->node_inx);
+	}
+	sim->node_undo_cnt = 0;
+
+	for (i = 0; i < sim->part_undo_cnt; i++) {
+		part_undo = &sim->part_undo[i];
+		if (part_undo->p_ptr->row) {
+			_destroy_row_data(part_undo->p_ptr->row,
+					  part_undo->p_ptr->num_rows);
+		}
+		part_undo->p_ptr->row = part_undo->orig_row;
+	}
+	sim->part_undo_cnt = 0;
+}
+
+/* Terminate a simulation started with _sim_begin() */
+static void _sim_end(struct cr_sim *sim)
+{
+	struct part_res_record *p_ptr;
+
+	if (!sim)
+		return;
+
+	_sim_rollback(sim);
+	while ((p_ptr = sim->part)) {
+		sim->part = p_ptr->next;
+		xfree(p_ptr);		/* row data is shared with live state */
+	}
+	xfree(sim->usage);
+	FREE_NULL_BITMAP(sim->node_logged);
+	xfree(sim->node_undo);
+	xfree(sim->part_undo);
+	xfree(sim);
+}
+
 
 static void _add_job_to_row(struct job_resources *job,
 			    struct part_row_data *r_ptr)
@@ -1526,6 +1649,199 @@ static int _sort_usable_nodes_dec(void *j1, void *j2)
 	return 0;
 }
 
+/*
+ * Preemptee screening for _run_now(): track an upper bound of the CPUs and
+ * memory which the pending job could get on each of its usable nodes, given
+ * the cores currently free in the job's partition plus the resources released
+ * by the preemptees removed so far. A full cr_job_test() can only succeed
+ * once enough nodes could satisfy the job's per-node requirements, so the
+ * (expensive) test is skipped until then.
+ */
+struct preempt_screen {
+	uint32_t *avail_cpus;	/* per node upper bound of usable CPUs */
+	uint64_t *avail_mem;	/* per node upper bound of usable memory */
+	bitstr_t *fit_map;	/* usable nodes which could satisfy the job */
+	bitstr_t *node_map;	/* nodes usable by the job */
+	uint32_t need_cpus;	/* CPUs needed per node */
+	uint64_t need_mem;	/* memory needed per node, 0 if not tracked */
+	bool whole_node;	/* job needs all CPUs of each node */
+};
+
+static uint64_t preempt_tests_run   = 0;
+static uint64_t preempt_tests_saved = 0;
+
+/* Update fit_map for one node of a preempt_screen */
+static void _screen_node_fit(struct preempt_screen *screen, int node_inx)
+{
+	uint32_t need_cpus = screen->need_cpus;
+
+	if (screen->whole_node) {
+		need_cpus = MAX(need_cpus, cr_node_num_cores[node_inx] *
+					   select_node_record[node_inx].vpus);
+	}
+	if ((screen->avail_cpus[node_inx] >= need_cpus) &&
+	    (screen->avail_mem[node_inx] >= screen->need_mem))
+		bit_set(screen->fit_map, node_inx);
+	else
+		bit_clear(screen->fit_map, node_inx);
+}
+
+/* Build a preempt_screen for job_ptr on the nodes in node_map.
+ * Release with _screen_free() */
+static struct preempt_screen *_screen_init(struct job_record *job_ptr,
+					   bitstr_t *node_map,
+					   uint16_t job_node_req,
+					   uint16_t tmp_cr_type)
+{
+	struct preempt_screen *screen;
+	struct job_details *details = job_ptr->details;
+	struct part_res_record *p_ptr;
+	struct node_res_record *node_res_ptr;
+	uint32_t coff, cores, free_cores, row_free;
+	uint64_t mem_limit;
+	int i, i_first, i_last, r;
+
+	for (p_ptr = select_part_record; p_ptr; p_ptr = p_ptr->next) {
+		if (p_ptr->part_ptr == job_ptr->part_ptr)
+			break;
+	}
+
+	screen = xmalloc(sizeof(struct preempt_screen));
+	screen->avail_cpus = xmalloc(sizeof(uint32_t) * select_node_cnt);
+	screen->avail_mem  = xmalloc(sizeof(uint64_t) * select_node_cnt);
+	screen->fit_map    = bit_alloc(select_node_cnt);
+	screen->node_map   = bit_copy(node_map);
+	screen->need_cpus  = MAX(details->pn_min_cpus, 1);
+	screen->whole_node = (job_node_req == NODE_CR_RESERVED) ||
+			     (details->whole_node == 1);
+	if ((tmp_cr_type & CR_MEMORY) && details->pn_min_memory) {
+		if (details->pn_min_memory & MEM_PER_CPU) {
+			screen->need_mem = details->pn_min_memory &
+					   (~MEM_PER_CPU);
+			screen->need_mem *= screen->need_cpus;
+		} else
+			screen->need_mem = details->pn_min_memory;
+	}
+
+	i_first = bit_ffs(node_map);
+	if (i_first == -1)
+		i_last = -2;
+	else
+		i_last = bit_fls(node_map);
+	for (i = i_first; i <= i_last; i++) {
+		if (!bit_test(node_map, i))
+			continue;
+		node_res_ptr = &select_node_record[i];
+		cores = cr_node_num_cores[i];
+		coff = cr_get_coremap_offset(i);
+		free_cores = cores;
+		if (p_ptr && p_ptr->row) {
+			/* The job can use the emptiest row on this node */
+			free_cores = 0;
+			for (r = 0; r < p_ptr->num_rows; r++) {
+				row_free = cores;
+				if (p_ptr->row[r].row_bitmap) {
+					row_free -= bit_set_count_range(
+						p_ptr->row[r].row_bitmap,
+						coff, coff + cores);
+				}
+				free_cores = MAX(free_cores, row_free);
+			}
+		}
+		screen->avail_cpus[i] = free_cores * node_res_ptr->vpus;
+
+		mem_limit = node_res_ptr->real_memory -
+			    node_res_ptr->mem_spec_limit;
+		if (select_node_usage[i].alloc_memory < mem_limit) {
+			screen->avail_mem[i] = mem_limit -
+					       select_node_usage[i].alloc_memory;
+		}
+		_screen_node_fit(screen, i);
+	}
+
+	return screen;
+}
+
+/* Add the resources of a removed preemptee to a preempt_screen. Credit
+ * every CPU of its allocated cores, which may exceed its CPU count, so the
+ * bound stays optimistic */
+static void _screen_rm_job(struct preempt_screen *screen,
+			   struct job_record *job_ptr)
+{
+	struct job_resources *job = job_ptr->job_resrcs;
+	uint32_t freed_cpus, node_cpus;
+	int i, i_first, i_last, n;
+
+	if (!job || !job->node_bitmap || !job->cpus)
+		return;
+
+	i_first = bit_ffs(job->node_bitmap);
+	if (i_first == -1)
+		i_last = -2;
+	else
+		i_last = bit_fls(job->node_bitmap);
+	for (i = i_first, n = -1; i <= i_last; i++) {
+		if (!bit_test(job->node_bitmap, i))
+			continue;
+		n++;
+		if (!bit_test(screen->node_map, i))
+			continue;
+		freed_cpus = job->cpus[n];
+		if (job->core_bitmap) {
+			freed_cpus = MAX(freed_cpus,
+					 count_job_resources_node(job, n) *
+					 select_node_record[i].vpus);
+		}
+		node_cpus = cr_node_num_cores[i] * select_node_record[i].vpus;
+		screen->avail_cpus[i] = MIN(screen->avail_cpus[i] + freed_cpus,
+					    node_cpus);
+		if (job->memory_allocated)
+			screen->avail_mem[i] += job->memory_allocated[n];
+		_screen_node_fit(screen, i);
+	}
+}
+
+/* Return true if the nodes which could satisfy the job might be enough for
+ * a cr_job_test() to succeed */
+static bool _screen_job_fits(struct preempt_screen *screen,
+			     struct job_record *job_ptr, uint32_t min_nodes)
+{
+	struct job_details *details = job_ptr->details;
+	uint32_t total_cpus = 0;
+	int i, i_first, i_last;
+
+	if (bit_set_count(screen->fit_map) < min_nodes)
+		return false;
+	if (details->req_node_bitmap &&
+	    !bit_super_set(details->req_node_bitmap, screen->fit_map))
+		return false;
+
+	i_first = bit_ffs(screen->fit_map);
+	if (i_first == -1)
+		i_last = -2;
+	else
+		i_last = bit_fls(screen->fit_map);
+	for (i = i_first; i <= i_last; i++) {
+		if (!bit_test(screen->fit_map, i))
+			continue;
+		total_cpus += screen->avail_cpus[i];
+		if (total_cpus >= details->min_cpus)
+			return true;
+	}
+	return false;
+}
+
+static void _screen_free(struct preempt_screen *screen)
+{
+	if (!screen)
+		return;
+	xfree(screen->avail_cpus);
+	xfree(screen->avail_mem);
+	FREE_NULL_BITMAP(screen->fit_map);
+	FREE_NULL_BITMAP(screen->node_map);
+	xfree(screen);
+}
+
 /* Allocate resources for a job now, if possible */
 static int _run_now(struct job_record *job_ptr, bitstr_t *bitmap,
 		    uint32_t min_nodes, uint32_t max_nodes,
@@ -1537,13 +1853,15 @@ static int _run_now(struct job_record *job_ptr, bitstr_t *bitmap,
 	bitstr_t *orig_map = NULL, *save_bitmap;
 	struct job_record *tmp_job_ptr = NULL;
 	ListIterator job_iterator, preemptee_iterator;
-	struct part_res_record *future_part;
-	struct node_use_record *future_usage;
-	bool remove_some_jobs = false;
+	struct cr_sim *sim = NULL;
+	struct preempt_screen *screen;
+	bool remove_some_jobs = false, test_pending = false;
+	bool screen_off = false;
 	uint16_t pass_count = 0;
 	uint16_t mode = (uint16_t) NO_VAL;
 	uint16_t tmp_cr_type = cr_type;
 	bool preempt_mode = false;
+	uint32_t tests_run = 0, tests_saved = 0;
 
 	save_bitmap = bit_copy(bitmap);
 top:	orig_map = bit_copy(save_bitmap);
@@ -1587,19 +1905,13 @@ top:	orig_map = bit_copy(save_bitmap);
 		int preemptee_cand_cnt = list_count(preemptee_candidates);
 		/* Remove preemptable jobs from simulated environment */
 		preempt_mode = true;
-		future_part = _dup_part_data(select_part_record);
-		if (future_part == NULL) {
-			FREE_NULL_BITMAP(orig_map);
-			FREE_NULL_BITMAP(save_bitmap);
-			return SLURM_ERROR;
-		}
-		future_usage = _dup_node_usage(select_node_usage);
-		if (future_usage == NULL) {
-			_destroy_part_data(future_part);
+		if (!sim && !(sim = _sim_begin())) {
 			FREE_NULL_BITMAP(orig_map);
 			FREE_NULL_BITMAP(save_bitmap);
 			return SLURM_ERROR;
 		}
+		screen = _screen_init(job_ptr, orig_map, job_node_req,
+				      tmp_cr_type);
 
 		job_iterator = list_iterator_create(preemptee_candidates);
 		while ((tmp_job_ptr = (struct job_record *)
@@ -1612,19 +1924,34 @@ top:	orig_map = bit_copy(save_bitmap);
 			    (mode != PREEMPT_MODE_CHECKPOINT) &&
 			    (mode != PREEMPT_MODE_CANCEL))
 				continue;	/* can't remove job */
+			tmp_job_ptr->details->usable_nodes = 0;
+			if (!tmp_job_ptr->node_bitmap ||
+			    !bit_overlap(orig_map, tmp_job_ptr->node_bitmap)) {
+				/* Removing job frees no usable resources */
+				tests_saved++;
+				continue;
+			}
 			/* Remove preemptable job now */
-			_rm_job_from_res(future_part, future_usage,
-					 tmp_job_ptr, 0);
+			_sim_rm_job(sim, tmp_job_ptr, 0);
+			_screen_rm_job(screen, tmp_job_ptr);
+			if (!screen_off &&
+			    !_screen_job_fits(screen, job_ptr, min_nodes)) {
+				/* Too few resources freed yet for job */
+				test_pending = true;
+				tests_saved++;
+				continue;
+			}
+			test_pending = false;
 			bit_or(bitmap, orig_map);
 			rc = cr_job_test(job_ptr, bitmap, min_nodes,
 					 max_nodes, req_nodes,
 					 SELECT_MODE_WILL_RUN,
 					 tmp_cr_type, job_node_req,
 					 select_node_cnt,
-					 future_part, future_usage,
+					 sim->part, sim->usage,
 					 exc_core_bitmap, false, false,
 					 preempt_mode);
-			tmp_job_ptr->details->usable_nodes = 0;
+			tests_run++;
 			if (rc != SLURM_SUCCESS)
 				continue;
 
@@ -1674,11 +2001,37 @@ top:	orig_map = bit_copy(save_bitmap);
 			}
 			FREE_NULL_BITMAP(orig_map);
 			list_iterator_destroy(job_iterator);
-			_destroy_part_data(future_part);
-			_destroy_node_data(future_usage, NULL);
+			_screen_free(screen);
+			_sim_rollback(sim);
 			goto top;
 		}
 		list_iterator_destroy(job_iterator);
+		_screen_free(screen);
+
+		if ((rc != SLURM_SUCCESS) && test_pending) {
+			/* Screening only estimates resources, so test with
+			 * all preemptable jobs removed before giving up */
+			bit_or(bitmap, orig_map);
+			rc = cr_job_test(job_ptr, bitmap, min_nodes,
+					 max_nodes, req_nodes,
+					 SELECT_MODE_WILL_RUN,
+					 tmp_cr_type, job_node_req,
+					 select_node_cnt,
+					 sim->part, sim->usage,
+					 exc_core_bitmap, false, false,
+					 preempt_mode);
+			tests_run++;
+			if (rc == SLURM_SUCCESS) {
+				/* The screen underestimated what some
+				 * preemptee frees. Test each candidate again
+				 * so the usual reordering minimizes the jobs
+				 * preempted, rather than taking them all */
+				screen_off = true;
+				FREE_NULL_BITMAP(orig_map);
+				_sim_rollback(sim);
+				goto top;
+			}
+		}
 
 		if ((rc == SLURM_SUCCESS) && preemptee_job_list &&
 		    preemptee_candidates) {
@@ -1708,13 +2061,23 @@ top:	orig_map = bit_copy(save_bitmap);
 				FREE_NULL_LIST(*preemptee_job_list);
 			}
 		}
-
-		_destroy_part_data(future_part);
-		_destroy_node_data(future_usage, NULL);
 	}
+	_sim_end(sim);
 	FREE_NULL_BITMAP(orig_map);
 	FREE_NULL_BITMAP(save_bitmap);
 
+	if (tests_run || tests_saved) {
+		preempt_tests_run   += tests_run;
+		preempt_tests_saved += tests_saved;
+		if (select_debug_flags & DEBUG_FLAG_SELECT_TYPE) {
+			info("cons_res: _run_now: job %u preemptee job tests "
+			     "run:%u saved:%u (total run:%"PRIu64" "
+			     "saved:%"PRIu64")", job_ptr->job_id, tests_run,
+			     tests_saved, preempt_tests_run,
+			     preempt_tests_saved);
+		}
+	}
+
 	return rc;
 }
 
@@ -1771,8 +2134,7 @@ static int _will_run_test(struct job_record *job_ptr, bitstr_t *bitmap,
 			  List preemptee_candidates, List *preemptee_job_list,
 			  bitstr_t *exc_core_bitmap)
 {
-	struct part_res_record *future_part;
-	struct node_use_record *future_usage;
+	struct cr_sim *sim;
 	struct job_record *tmp_job_ptr;
 	List cr_job_list;
 	ListIterator job_iterator, preemptee_iterator;
@@ -1808,14 +2170,8 @@ static int _will_run_test(struct job_record *job_ptr, bitstr_t *bitmap,
 
 	/* Job is still pending. Simulate termination of jobs one at a time
 	 * to determine when and where the job can start. */
-	future_part = _dup_part_data(select_part_record);
-	if (future_part == NULL) {
-		FREE_NULL_BITMAP(orig_map);
-		return SLURM_ERROR;
-	}
-	future_usage = _dup_node_usage(select_node_usage);
-	if (future_usage == NULL) {
-		_destroy_part_data(future_part);
+	sim = _sim_begin();
+	if (sim == NULL) {
 		FREE_NULL_BITMAP(orig_map);
 		return SLURM_ERROR;
 	}
@@ -1856,8 +2212,7 @@ static int _will_run_test(struct job_record *job_ptr, bitstr_t *bitmap,
 			} else
 				action = 0;	/* remove cores and memory */
 			/* Remove preemptable job now */
-			_rm_job_from_res(future_part, future_usage,
-					 tmp_job_ptr, action);
+			_sim_rm_job(sim, tmp_job_ptr, action);
 		} else
 			list_append(cr_job_list, tmp_job_ptr);
 	}
@@ -1868,8 +2223,8 @@ static int _will_run_test(struct job_record *job_ptr, bitstr_t *bitmap,
 		bit_or(bitmap, orig_map);
 		rc = cr_job_test(job_ptr, bitmap, min_nodes, max_nodes,
 				 req_nodes, SELECT_MODE_WILL_RUN, tmp_cr_type,
-				 job_node_req, select_node_cnt, future_part,
-				 future_usage, exc_core_bitmap, false,
+				 job_node_req, select_node_cnt, sim->part,
+				 sim->usage, exc_core_bitmap, false,
 				 qos_preemptor, true);
 		if (rc == SLURM_SUCCESS) {
 			/* Actual start time will actually be later than "now",
@@ -1911,8 +2266,7 @@ static int _will_run_test(struct job_record *job_ptr, bitstr_t *bitmap,
 				if (!first_job_ptr)
 					first_job_ptr = tmp_job_ptr;
 				last_job_ptr = tmp_job_ptr;
-				_rm_job_from_res(future_part, future_usage,
-						 tmp_job_ptr, 0);
+				_sim_rm_job(sim, tmp_job_ptr, 0);
 				if (rm_job_cnt++ > 200)
 					break;
 				next_job_ptr = list_peek_next(job_iterator);
@@ -1932,7 +2286,7 @@ static int _will_run_test(struct job_record *job_ptr, bitstr_t *bitmap,
 					 max_nodes, req_nodes,
 					 SELECT_MODE_WILL_RUN, tmp_cr_type,
 					 job_node_req, select_node_cnt,
-					 future_part, future_usage,
+					 sim->part, sim->usage,
 					 exc_core_bitmap, backfill_busy_nodes,
 					 qos_preemptor, true);
 			if (rc == SLURM_SUCCESS) {
@@ -1973,8 +2327,7 @@ static int _will_run_test(struct job_record *job_ptr, bitstr_t *bitmap,
 	}
 
 	FREE_NULL_LIST(cr_job_list);
-	_destroy_part_data(future_part);
-	_destroy_node_data(future_usage, NULL);
+	_sim_end(sim);
 	FREE_NULL_BITMAP(orig_map);
 	return rc;
 }
@@ -2030,6 +2383,7 @@ extern int fini(void)
 	_destroy_part_data(select_part_record);
 	select_part_record = NULL;
 	cr_fini_global_core_data();
+	cr_topo_cache_fini();
 
 	if (cr_type)
 		verbose("%s shutting down ...", plugin_name);
@@ -2149,6 +2503,7 @@ extern int select_p_node_init(struct node_record *node_ptr, int node_cnt)
 	select_state_initializing = true;
 	select_fast_schedule = slurm_get_fast_schedule();
 	cr_init_global_core_data(node_ptr, node_cnt, select_fast_schedule);
+	cr_topo_cache_fini();	/* switch table may have been rebuilt */
 
 	_destroy_node_data(select_node_usage, select_node_record);
 	select_node_cnt  = node_cnt;
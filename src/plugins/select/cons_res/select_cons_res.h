@@ -104,6 +104,33 @@ struct node_use_record {
 	uint16_t node_state;		/* see node_cr_state comments */
 };
 
+/* undo log entry: a node's usage record before a simulated job removal */
+struct sim_node_undo {
+	int node_inx;			/* index of the modified node */
+	struct node_use_record orig;	/* usage record before modification */
+};
+
+/* undo log entry: a partition's rows before a simulated job removal */
+struct sim_part_undo {
+	struct part_res_record *p_ptr;	/* simulated partition record */
+	struct part_row_data *orig_row;	/* row data before modification */
+};
+
+/* what-if view of the partition and node usage data, used to test if and
+ * when a job could start after other jobs are removed (preempted or ended).
+ * Records are shared with the live data until modified. */
+struct cr_sim {
+	struct part_res_record *part;	/* shallow copy of select_part_record */
+	struct node_use_record *usage;	/* shallow copy of select_node_usage */
+	bitstr_t *node_logged;		/* nodes with a node_undo entry */
+	struct sim_node_undo *node_undo;/* undo log of modified nodes */
+	int node_undo_cnt;		/* entries used in node_undo */
+	int node_undo_size;		/* entries allocated in node_undo */
+	struct sim_part_undo *part_undo;/* undo log of modified partitions */
+	int part_undo_cnt;		/* entries used in part_undo */
+	int part_undo_size;		/* entries allocated in part_undo */
+};
+
 extern bool     backfill_busy_nodes;
 extern bool     have_dragonfly;
 extern bool     pack_serial_at_end;
@@ -137,7 +137,6 @@ static job_resources_t *_create_job_resources(int node_cnt);
 static int _decr_node_job_cnt(int node_inx, struct job_record *job_ptr,
 			      char *pre_err);
 static void _dump_node_cr(struct cr_record *cr_ptr);
-static struct cr_record *_dup_cr(struct cr_record *cr_ptr);
 static int  _find_job_mate(struct job_record *job_ptr, bitstr_t *bitmap,
 			   uint32_t min_nodes, uint32_t max_nodes,
 			   uint32_t req_nodes);
@@ -170,6 +169,12 @@ static int _rm_job_from_nodes(struct cr_record *cr_ptr,
 			      bool remove_all);
 static int _rm_job_from_one_node(struct job_record *job_ptr,
 				 struct node_record *node_ptr, char *pre_err);
+static void _sim_end(struct cr_sim *sim);
+static struct cr_sim *_sim_begin(void);
+static void _sim_log_node(struct cr_sim *sim, int node_inx);
+static void _sim_rollback(struct cr_sim *sim);
+static int _sim_rm_job(struct cr_sim *sim, struct job_record *job_ptr,
+		       char *pre_err, bool remove_all);
 static int _run_now(struct job_record *job_ptr, bitstr_t *bitmap,
 		    uint32_t min_nodes, uint32_t max_nodes,
 		    int max_share, uint32_t req_nodes,
@@ -2940,57 +2945,151 @@ static void _dump_node_cr(struct cr_record *cr_ptr)
 #endif
 }
 
-static struct cr_record *_dup_cr(struct cr_record *cr_ptr)
+/*
+ * What-if simulation support for preemption and will-run tests.
+ *
+ * Rather than duplicating the cr_record of every node before simulating the
+ * removal of running jobs, a simulation shares the live per-node records and
+ * copies one only when a hypothetical job removal is about to modify it. The
+ * original record is kept in an undo log, so a simulation can be rolled back
+ * to the live state (and reused) at a cost proportional to the number of
+ * nodes actually modified.
+ */
+static struct cr_sim *_sim_begin(void)
 {
+	struct cr_sim *sim;
 	int i;
-	struct cr_record *new_cr_ptr;
-	struct part_cr_record *part_cr_ptr, *new_part_cr_ptr;
-	struct node_record *node_ptr;
-	List gres_list;
 
 	if (cr_ptr == NULL)
 		return NULL;
 
-	new_cr_ptr = xmalloc(sizeof(struct cr_record));
-	new_cr_ptr->run_job_len = cr_ptr->run_job_len;
+	sim = xmalloc(sizeof(struct cr_sim));
+	sim->cr = xmalloc(sizeof(struct cr_record));
+	sim->cr->run_job_len = cr_ptr->run_job_len;
 	i = sizeof(uint32_t) * cr_ptr->run_job_len;
-	new_cr_ptr->run_job_ids = xmalloc(i);
-	memcpy(new_cr_ptr->run_job_ids, cr_ptr->run_job_ids, i);
-	new_cr_ptr->tot_job_len = cr_ptr->tot_job_len;
+	sim->cr->run_job_ids = xmalloc(i);
+	memcpy(sim->cr->run_job_ids, cr_ptr->run_job_ids, i);
+	sim->cr->tot_job_len = cr_ptr->tot_job_len;
 	i = sizeof(uint32_t) * cr_ptr->tot_job_len;
-	new_cr_ptr->tot_job_ids = xmalloc(i);
-	memcpy(new_cr_ptr->tot_job_ids, cr_ptr->tot_job_ids, i);
+	sim->cr->tot_job_ids = xmalloc(i);
+	memcpy(sim->cr->tot_job_ids, cr_ptr->tot_job_ids, i);
 
-	new_cr_ptr->nodes = xmalloc(select_node_cnt *
-				    sizeof(struct node_cr_record));
-	for (i = 0; i < select_node_cnt; i++) {
-		node_ptr = node_record_table_ptr + i;
-		new_cr_ptr->nodes[i].alloc_memory = cr_ptr->nodes[i].
-			alloc_memory;
-		new_cr_ptr->nodes[i].exclusive_cnt = cr_ptr->nodes[i].
-			exclusive_cnt;
+	/* Node records (part lists and GRES state) are copied on write */
+	i = sizeof(struct node_cr_record) * select_node_cnt;
+	sim->cr->nodes = xmalloc(i);
+	memcpy(sim->cr->nodes, cr_ptr->nodes, i);
+	sim->node_logged = bit_alloc(select_node_cnt);
 
-		part_cr_ptr = cr_ptr->nodes[i].parts;
-		while (part_cr_ptr) {
-			new_part_cr_ptr =
-				xmalloc(sizeof(struct part_cr_record));
-			new_part_cr_ptr->part_ptr    = part_cr_ptr->part_ptr;
-			new_part_cr_ptr->run_job_cnt = part_cr_ptr->run_job_cnt;
-			new_part_cr_ptr->tot_job_cnt = part_cr_ptr->tot_job_cnt;
-			new_part_cr_ptr->next 	     = new_cr_ptr->nodes[i].
-				parts;
-			new_cr_ptr->nodes[i].parts   = new_part_cr_ptr;
-			part_cr_ptr = part_cr_ptr->next;
+	return sim;
+}
+
+/* Give a simulated node a private copy of its cr_record before change */
+static void _sim_log_node(struct cr_sim *sim, int node_inx)
+{
+	struct node_cr_record *node_cr_ptr = &sim->cr->nodes[node_inx];
+	struct part_cr_record *part_cr_ptr, *new_part_cr_ptr;
+	struct sim_node_undo *undo;
+	List gres_list;
+
+	if (bit_test(sim->node_logged, node_inx))
+		return;
+	bit_set(sim->node_logged, node_inx);
+
+	if (sim->node_undo_cnt >= sim->node_undo_size) {
+		sim->node_undo_size += 64;
+		xrealloc(sim->node_undo, sim->node_undo_size *
+			 sizeof(struct sim_node_undo));
+	}
+	undo = &sim->node_undo[sim->node_undo_cnt++];
+	undo->node_inx = node_inx;
+	undo->orig = *node_cr_ptr;
+
+	node_cr_ptr->parts = NULL;
+	part_cr_ptr = undo->orig.parts;
+	while (part_cr_ptr) {
+		new_part_cr_ptr = xmalloc(sizeof(struct part_cr_record));
+		new_part_cr_ptr->part_ptr    = part_cr_ptr->part_ptr;
+		new_part_cr_ptr->run_job_cnt = part_cr_ptr->run_job_cnt;
+		new_part_cr_ptr->tot_job_cnt = part_cr_ptr->tot_job_cnt;
+		new_part_cr_ptr->next        = node_cr_ptr->parts;
+		node_cr_ptr->parts           = new_part_cr_ptr;
+		part_cr_ptr = part_cr_ptr->next;
+	}
+
+	if (undo->orig.gres_list)
+		gres_list = undo->orig.gres_list;
+	else
+		gres_list = node_record_table_ptr[node_inx].gres_list;
+	node_cr_ptr->gres_list = gres_plugin_node_state_dup(gres_list);
+}
+
+/* Hypothetically remove a job's resources from a simulation, see
+ * _rm_job_from_nodes() for a description of remove_all */
+static int _sim_rm_job(struct cr_sim *sim, struct job_record *job_ptr,
+		       char *pre_err, bool remove_all)
+{
+	job_resources_t *job_resrcs_ptr = job_ptr->job_resrcs;
+	int i, i_first, i_last;
+
+	if (job_resrcs_ptr && job_resrcs_ptr->node_bitmap &&
+	    job_ptr->node_bitmap) {
+		i_first = bit_ffs(job_resrcs_ptr->node_bitmap);
+		i_last  = bit_fls(job_resrcs_ptr->node_bitmap);
+		if (i_first == -1)	/* job has no nodes */
+			i_last = -2;
+		for (i = i_first; i <= i_last; i++) {
+			if (!bit_test(job_resrcs_ptr->node_bitmap, i) ||
+			    !bit_test(job_ptr->node_bitmap, i))
+				continue;
+			_sim_log_node(sim, i);
 		}
+	}
 
-		if (cr_ptr->nodes[i].gres_list)
-			gres_list = cr_ptr->nodes[i].gres_list;
-		else
-			gres_list = node_ptr->gres_list;
-		new_cr_ptr->nodes[i].gres_list =
-			gres_plugin_node_state_dup(gres_list);
+	return _rm_job_from_nodes(sim->cr, job_ptr, pre_err, remove_all);
+}
+
+/* Undo all job removals, restoring the simulation to the live state */
+static void _sim_rollback(struct cr_sim *sim)
+{
+	struct node_cr_record *node_cr_ptr;
+	struct part_cr_record *part_cr_ptr1, *part_cr_ptr2;
+	int i;
+
+	for (i = 0; i < sim->node_undo_cnt; i++) {
+		node_cr_ptr = &sim->cr->nodes[sim->node_undo[i].node_inx];
+		part_cr_ptr1 = node_cr_ptr->parts;
+		while (part_cr_ptr1) {
+			part_cr_ptr2 = part_cr_ptr1->next;
+			xfree(part_cr_ptr1);
+			part_cr_ptr1 = part_cr_ptr2;
+		}
+		FREE_NULL_LIST(node_cr_ptr->gres_list);
+		*node_cr_ptr = sim->node_undo[i].orig;
+		bit_clear(sim->node_logged, sim->node_undo[i].node_inx);
 	}
-	return new_cr_ptr;
+	sim->node_undo_cnt = 0;
+
+	/* Removed jobs only have their IDs cleared, array sizes are unchanged */
+	memcpy(sim->cr->run_job_ids, cr_ptr->run_job_ids,
+	       sizeof(uint32_t) * sim->cr->run_job_len);
+	memcpy(sim->cr->tot_job_ids, cr_ptr->tot_job_ids,
+	       sizeof(uint32_t) * sim->cr->tot_job_len);
+}
+
+/* Terminate a simulation started with _sim_begin() */
+static void _sim_end(struct cr_sim *sim)
+{
+	if (sim == NULL)
+		return;
+
+	_sim_rollback(sim);
+	xfree(sim->cr->nodes);
+	xfree(sim->cr->run_job_ids);
+	xfree(sim->cr->tot_job_ids);
+	xfree(sim->cr);
+	FREE_NULL_BITMAP(sim->node_logged);
+	xfree(sim->node_undo);
+	xfree(sim);
 }
 
 static void _init_node_cr(void)
@@ -3217,7 +3316,7 @@ static int _run_now(struct job_record *job_ptr, bitstr_t *bitmap,
 	int max_run_job, j, sus_jobs, rc = EINVAL, prev_cnt = -1;
 	struct job_record *tmp_job_ptr;
 	ListIterator job_iterator, preemptee_iterator;
-	struct cr_record *exp_cr;
+	struct cr_sim *sim = NULL;
 	uint16_t pass_count = 0;
 
 	orig_map = bit_copy(bitmap);
@@ -3260,8 +3359,9 @@ static int _run_now(struct job_record *job_ptr, bitstr_t *bitmap,
 		}
 	}
 
-top:	if ((rc != SLURM_SUCCESS) && preemptee_candidates &&
-	    (exp_cr = _dup_cr(cr_ptr))) {
+	if ((rc != SLURM_SUCCESS) && preemptee_candidates)
+		sim = _sim_begin();
+top:	if ((rc != SLURM_SUCCESS) && sim) {
 		/* Remove all preemptable jobs from simulated environment */
 		job_iterator = list_iterator_create(preemptee_candidates);
 		while ((tmp_job_ptr = (struct job_record *)
@@ -3278,10 +3378,8 @@ top:	if ((rc != SLURM_SUCCESS) && preemptee_candidates &&
 			    (mode == PREEMPT_MODE_CANCEL))
 				remove_all = true;
 			/* Remove preemptable job now */
-			_rm_job_from_nodes(exp_cr, tmp_job_ptr,
-					   "_run_now",
-					   remove_all);
-			j = _job_count_bitmap(exp_cr, job_ptr,
+			_sim_rm_job(sim, tmp_job_ptr, "_run_now", remove_all);
+			j = _job_count_bitmap(sim->cr, job_ptr,
 					      orig_map, bitmap,
 					      (max_share - 1),
 					      NO_SHARE_LIMIT,
@@ -3310,7 +3408,7 @@ top:	if ((rc != SLURM_SUCCESS) && preemptee_candidates &&
 					  (ListCmpF)_sort_usable_nodes_dec);
 				rc = EINVAL;
 				list_iterator_destroy(job_iterator);
-				_free_cr(exp_cr);
+				_sim_rollback(sim);
 				goto top;
 			}
 		}
@@ -3337,8 +3435,8 @@ top:	if ((rc != SLURM_SUCCESS) && preemptee_candidates &&
 			}
 			list_iterator_destroy(preemptee_iterator);
 		}
-		_free_cr(exp_cr);
 	}
+	_sim_end(sim);
 	if (rc == SLURM_SUCCESS)
 		_build_select_struct(job_ptr, bitmap);
 	FREE_NULL_BITMAP(orig_map);
@@ -3356,7 +3454,7 @@ static int _will_run_test(struct job_record *job_ptr, bitstr_t *bitmap,
 			  List preemptee_candidates,
 			  List *preemptee_job_list)
 {
-	struct cr_record *exp_cr;
+	struct cr_sim *sim;
 	struct job_record *tmp_job_ptr;
 	List cr_job_list;
 	ListIterator job_iterator, preemptee_iterator;
@@ -3383,8 +3481,8 @@ static int _will_run_test(struct job_record *job_ptr, bitstr_t *bitmap,
 
 	/* Job is still pending. Simulate termination of jobs one at a time
 	 * to determine when and where the job can start. */
-	exp_cr = _dup_cr(cr_ptr);
-	if (exp_cr == NULL) {
+	sim = _sim_begin();
+	if (sim == NULL) {
 		FREE_NULL_BITMAP(orig_map);
 		return SLURM_ERROR;
 	}
@@ -3408,8 +3506,8 @@ static int _will_run_test(struct job_record *job_ptr, bitstr_t *bitmap,
 			    (mode == PREEMPT_MODE_CANCEL))
 				remove_all = true;
 			/* Remove preemptable job now */
-			_rm_job_from_nodes(exp_cr, tmp_job_ptr,
-					   "_will_run_test", remove_all);
+			_sim_rm_job(sim, tmp_job_ptr, "_will_run_test",
+				    remove_all);
 		} else
 			list_append(cr_job_list, tmp_job_ptr);
 
@@ -3418,7 +3516,7 @@ static int _will_run_test(struct job_record *job_ptr, bitstr_t *bitmap,
 
 	/* Test with all preemptable jobs gone */
 	if (preemptee_candidates) {
-		i = _job_count_bitmap(exp_cr, job_ptr, orig_map, bitmap,
+		i = _job_count_bitmap(sim->cr, job_ptr, orig_map, bitmap,
 				      max_run_jobs, NO_SHARE_LIMIT,
 				      SELECT_MODE_RUN_NOW);
 		if (i >= min_nodes) {
@@ -3441,9 +3539,8 @@ static int _will_run_test(struct job_record *job_ptr, bitstr_t *bitmap,
 		job_iterator = list_iterator_create(cr_job_list);
 		while ((tmp_job_ptr = (struct job_record *)
 			list_next(job_iterator))) {
-			_rm_job_from_nodes(exp_cr, tmp_job_ptr,
-					   "_will_run_test", true);
-			i = _job_count_bitmap(exp_cr, job_ptr, orig_map,
+			_sim_rm_job(sim, tmp_job_ptr, "_will_run_test", true);
+			i = _job_count_bitmap(sim->cr, job_ptr, orig_map,
 					      bitmap, max_run_jobs,
 					      NO_SHARE_LIMIT,
 					      SELECT_MODE_RUN_NOW);
@@ -3482,7 +3579,7 @@ static int _will_run_test(struct job_record *job_ptr, bitstr_t *bitmap,
 	}
 
 	FREE_NULL_LIST(cr_job_list);
-	_free_cr(exp_cr);
+	_sim_end(sim);
 	FREE_NULL_BITMAP(orig_map);
 	return rc;
 }
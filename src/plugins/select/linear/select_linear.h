@@ -83,4 +83,26 @@ struct cr_record {
 	uint16_t tot_job_len;		/* length of tot_job_ids array */
 };
 
+/*
+ * sim_node_undo records a node's cr_record as it was before a simulated
+ * job removal gave the node a private copy of it.
+ */
+struct sim_node_undo {
+	int node_inx;			/* index of the modified node */
+	struct node_cr_record orig;	/* node record before modification */
+};
+
+/*
+ * cr_sim is a what-if view of the cr_record used to test if and when a job
+ * could start after other jobs are removed (preempted or ended). Node records
+ * are shared with the live cr_record until modified.
+ */
+struct cr_sim {
+	struct cr_record *cr;		/* simulated state */
+	bitstr_t *node_logged;		/* nodes with a node_undo entry */
+	struct sim_node_undo *node_undo;/* undo log of modified nodes */
+	int node_undo_cnt;		/* entries used in node_undo */
+	int node_undo_size;		/* entries allocated in node_undo */
+};
+
 #endif /* !_SELECT_LINEAR_H */
@@ -45,6 +45,7 @@
 #include "src/slurmctld/acct_policy.h"
 #include "src/common/node_select.h"
 #include "src/common/slurm_priority.h"
+#include "src/common/xhash.h"
 
 #define _DEBUG 0
 
@@ -62,6 +63,34 @@ typedef enum {
 	TRES_USAGE_REQ_NOT_SAFE_WITH_USAGE
 } acct_policy_tres_usage_t;
 
+/*
+ * Memo of acct_policy_job_runnable_pre_select() results. Pending jobs tend
+ * to share an association and QOS, and once one of them is held by a job
+ * count limit every other one is as well until usage drops or the limits
+ * change. Only those count based holds are remembered since anything
+ * involving the job's own time limit or TRES request differs per job.
+ */
+#define PRE_SELECT_MEMO_SIZE 1024
+
+typedef struct {
+	uint32_t assoc_id;
+	uint32_t gen;
+	uint32_t qos_id_1;
+	uint32_t qos_id_2;
+	uint32_t state_reason;
+} pre_select_memo_t;
+
+static pthread_mutex_t pre_select_memo_lock = PTHREAD_MUTEX_INITIALIZER;
+static pre_select_memo_t pre_select_memo[PRE_SELECT_MEMO_SIZE];
+static uint32_t pre_select_memo_gen = 1;
+
+/*
+ * Protects qos_limit_index below, and the creation of acct_limit_list and
+ * user_limit_list records. Records are looked up and added by callers
+ * holding only the QOS read lock.
+ */
+static pthread_mutex_t used_limits_lock = PTHREAD_MUTEX_INITIALIZER;
+
 static int _get_tres_state_reason(int tres_pos, int unk_reason)
 {
 	switch (tres_pos) {
@@ -350,88 +379,282 @@ static void _set_qos_order(struct job_record *job_ptr,
 	return;
 }
 
-static int _find_used_limits_for_acct(void *x, void *key)
+static pre_select_memo_t *_pre_select_memo_ent(uint32_t assoc_id,
+						 slurmdb_qos_rec_t *qos_ptr_1,
+						 slurmdb_qos_rec_t *qos_ptr_2)
 {
-	slurmdb_used_limits_t *used_limits = (slurmdb_used_limits_t *)x;
-	char *account = (char *)key;
+	uint32_t qos_id_1 = qos_ptr_1 ? qos_ptr_1->id : 0;
+	uint32_t qos_id_2 = qos_ptr_2 ? qos_ptr_2->id : 0;
+	uint32_t inx;
 
-	if (!xstrcmp(account, used_limits->acct))
-		return 1;
+	inx = (assoc_id * 2654435761U) ^ (qos_id_1 * 40503U) ^ qos_id_2;
+	return &pre_select_memo[inx % PRE_SELECT_MEMO_SIZE];
+}
 
-	return 0;
+/* Return the remembered hold reason for this association and QOS pair,
+ * or WAIT_NO_REASON if there is none. */
+static uint32_t _pre_select_memo_get(uint32_t assoc_id,
+				     slurmdb_qos_rec_t *qos_ptr_1,
+				     slurmdb_qos_rec_t *qos_ptr_2)
+{
+	pre_select_memo_t *ent;
+	uint32_t state_reason = WAIT_NO_REASON;
+
+	slurm_mutex_lock(&pre_select_memo_lock);
+	ent = _pre_select_memo_ent(assoc_id, qos_ptr_1, qos_ptr_2);
+	if ((ent->gen == pre_select_memo_gen) &&
+	    (ent->assoc_id == assoc_id) &&
+	    (ent->qos_id_1 == (qos_ptr_1 ? qos_ptr_1->id : 0)) &&
+	    (ent->qos_id_2 == (qos_ptr_2 ? qos_ptr_2->id : 0)))
+		state_reason = ent->state_reason;
+	slurm_mutex_unlock(&pre_select_memo_lock);
+
+	return state_reason;
 }
 
-/* Checks for record in *user_limit_list of user_id if
- * *user_limit_list doesn't exist it will create it, if the user_id
- * record doesn't exist it will add it to the list.
- * In all cases the user record is returned.
- */
-static slurmdb_used_limits_t *_get_acct_used_limits(
-	List *acct_limit_list, char *acct)
+static void _pre_select_memo_set(uint32_t assoc_id,
+				 slurmdb_qos_rec_t *qos_ptr_1,
+				 slurmdb_qos_rec_t *qos_ptr_2,
+				 uint32_t state_reason)
+{
+	pre_select_memo_t *ent;
+
+	switch (state_reason) {
+	case WAIT_QOS_GRP_JOB:
+	case WAIT_QOS_MAX_JOB_PER_ACCT:
+	case WAIT_QOS_MAX_JOB_PER_USER:
+	case WAIT_ASSOC_GRP_JOB:
+	case WAIT_ASSOC_MAX_JOBS:
+		break;
+	default:
+		return;
+	}
+
+	slurm_mutex_lock(&pre_select_memo_lock);
+	ent = _pre_select_memo_ent(assoc_id, qos_ptr_1, qos_ptr_2);
+	ent->assoc_id = assoc_id;
+	ent->gen = pre_select_memo_gen;
+	ent->qos_id_1 = qos_ptr_1 ? qos_ptr_1->id : 0;
+	ent->qos_id_2 = qos_ptr_2 ? qos_ptr_2->id : 0;
+	ent->state_reason = state_reason;
+	slurm_mutex_unlock(&pre_select_memo_lock);
+}
+
+static const char *_acct_limit_hash_id(void *item)
 {
+	slurmdb_used_limits_t *used_limits = (slurmdb_used_limits_t *)item;
+
+	return used_limits->acct ? used_limits->acct : "";
+}
+
+/* The user index is keyed by the uid printed as a string, which needs a
+ * place to live for as long as the hash entry does. */
+typedef struct {
+	char uid_str[11];
 	slurmdb_used_limits_t *used_limits;
+} user_limit_ent_t;
 
-	xassert(acct_limit_list);
+static const char *_user_limit_hash_id(void *item)
+{
+	return ((user_limit_ent_t *)item)->uid_str;
+}
 
-	if (!*acct_limit_list)
-		*acct_limit_list = list_create(slurmdb_destroy_used_limits);
+static void _user_limit_hash_free(void *item)
+{
+	xfree(item);
+}
 
-	if (!(used_limits = list_find_first(*acct_limit_list,
-					    _find_used_limits_for_acct,
-					    acct))) {
-		int i = sizeof(uint64_t) * slurmctld_tres_cnt;
+static void _user_limit_hash_add(xhash_t *hash,
+				 slurmdb_used_limits_t *used_limits)
+{
+	user_limit_ent_t *ent = xmalloc(sizeof(user_limit_ent_t));
 
-		used_limits = xmalloc(sizeof(slurmdb_used_limits_t));
-		used_limits->acct = xstrdup(acct);
+	snprintf(ent->uid_str, sizeof(ent->uid_str), "%u", used_limits->uid);
+	ent->used_limits = used_limits;
+	xhash_add(hash, ent);
+}
 
-		used_limits->tres = xmalloc(i);
-		used_limits->tres_run_mins = xmalloc(i);
+/*
+ * Indexes of each QOS's acct_limit_list and user_limit_list, keyed by QOS
+ * id. They are kept here rather than in the QOS usage so that the public
+ * slurmdb_qos_usage_t is unchanged. Each index remembers the list it was
+ * built from and is rebuilt when the QOS usage holds another list or the
+ * list was filled in elsewhere. Protected by used_limits_lock.
+ */
+typedef struct {
+	char qos_id_str[11];
+	List acct_list;		/* acct_limit_list indexed by acct_hash */
+	xhash_t *acct_hash;
+	List user_list;		/* user_limit_list indexed by user_hash */
+	xhash_t *user_hash;
+} qos_limit_index_t;
+
+static xhash_t *qos_limit_index = NULL;
+
+static const char *_qos_limit_index_id(void *item)
+{
+	return ((qos_limit_index_t *)item)->qos_id_str;
+}
+
+static void _qos_limit_index_free(void *item)
+{
+	qos_limit_index_t *index = (qos_limit_index_t *)item;
 
-		list_append(*acct_limit_list, used_limits);
+	xhash_free_ptr(&index->acct_hash);
+	xhash_free_ptr(&index->user_hash);
+	xfree(index);
+}
+
+/* Caller must hold used_limits_lock */
+static qos_limit_index_t *_get_qos_limit_index(slurmdb_qos_rec_t *qos_ptr)
+{
+	qos_limit_index_t *index;
+	char qos_id_str[11];
+
+	if (!qos_limit_index)
+		qos_limit_index = xhash_init(_qos_limit_index_id,
+					     _qos_limit_index_free, NULL, 0);
+
+	snprintf(qos_id_str, sizeof(qos_id_str), "%u", qos_ptr->id);
+	if (!(index = xhash_get(qos_limit_index, qos_id_str))) {
+		index = xmalloc(sizeof(qos_limit_index_t));
+		memcpy(index->qos_id_str, qos_id_str, sizeof(qos_id_str));
+		xhash_add(qos_limit_index, index);
 	}
 
-	return used_limits;
+	return index;
 }
 
-static int _find_used_limits_for_user(void *x, void *key)
+/* The indexes only ever grow alongside their list (records are never
+ * removed outside of freeing the whole usage), so a count mismatch means
+ * the list was filled in elsewhere and the index is rebuilt.
+ * Caller must hold used_limits_lock. */
+static xhash_t *_acct_limit_hash(qos_limit_index_t *index, List list)
 {
-	slurmdb_used_limits_t *used_limits = (slurmdb_used_limits_t *)x;
-	uint32_t user_id = *(uint32_t *)key;
+	slurmdb_used_limits_t *used_limits;
+	ListIterator itr;
+
+	if (index->acct_hash && (index->acct_list == list) &&
+	    (xhash_count(index->acct_hash) == list_count(list)))
+		return index->acct_hash;
 
-	if (used_limits->uid == user_id)
-		return 1;
+	xhash_free_ptr(&index->acct_hash);
+	index->acct_hash = xhash_init(_acct_limit_hash_id, NULL, NULL, 0);
+	index->acct_list = list;
+	itr = list_iterator_create(list);
+	while ((used_limits = list_next(itr)))
+		xhash_add(index->acct_hash, used_limits);
+	list_iterator_destroy(itr);
 
-	return 0;
+	return index->acct_hash;
 }
 
-/* Checks for record in *user_limit_list of user_id if
- * *user_limit_list doesn't exist it will create it, if the user_id
+static xhash_t *_user_limit_hash(qos_limit_index_t *index, List list)
+{
+	slurmdb_used_limits_t *used_limits;
+	ListIterator itr;
+
+	if (index->user_hash && (index->user_list == list) &&
+	    (xhash_count(index->user_hash) == list_count(list)))
+		return index->user_hash;
+
+	xhash_free_ptr(&index->user_hash);
+	index->user_hash = xhash_init(_user_limit_hash_id,
+				      _user_limit_hash_free, NULL, 0);
+	index->user_list = list;
+	itr = list_iterator_create(list);
+	while ((used_limits = list_next(itr)))
+		_user_limit_hash_add(index->user_hash, used_limits);
+	list_iterator_destroy(itr);
+
+	return index->user_hash;
+}
+
+/* Checks for record in usage->acct_limit_list of acct if
+ * usage->acct_limit_list doesn't exist it will create it, if the acct
  * record doesn't exist it will add it to the list.
- * In all cases the user record is returned.
+ * In all cases the acct record is returned.
  */
-static slurmdb_used_limits_t *_get_user_used_limits(
-	List *user_limit_list, uint32_t user_id)
+static slurmdb_used_limits_t *_get_acct_used_limits(
+	slurmdb_qos_rec_t *qos_ptr, char *acct)
 {
+	slurmdb_qos_usage_t *usage = qos_ptr->usage;
 	slurmdb_used_limits_t *used_limits;
+	qos_limit_index_t *index;
+	xhash_t *hash;
+
+	xassert(usage);
+
+	slurm_mutex_lock(&used_limits_lock);
+	index = _get_qos_limit_index(qos_ptr);
+	if (!usage->acct_limit_list) {
+		usage->acct_limit_list =
+			list_create(slurmdb_destroy_used_limits);
+		/* A new list may reuse the address of a freed one */
+		xhash_free_ptr(&index->acct_hash);
+	}
 
-	xassert(user_limit_list);
-
-	if (!*user_limit_list)
-		*user_limit_list = list_create(slurmdb_destroy_used_limits);
-
-	if (!(used_limits = list_find_first(*user_limit_list,
-					    _find_used_limits_for_user,
-					    &user_id))) {
+	hash = _acct_limit_hash(index, usage->acct_limit_list);
+	if (!(used_limits = xhash_get(hash, acct ? acct : ""))) {
 		int i = sizeof(uint64_t) * slurmctld_tres_cnt;
 
 		used_limits = xmalloc(sizeof(slurmdb_used_limits_t));
-		used_limits->uid = user_id;
+		used_limits->acct = xstrdup(acct);
 
 		used_limits->tres = xmalloc(i);
 		used_limits->tres_run_mins = xmalloc(i);
 
-		list_append(*user_limit_list, used_limits);
+		list_append(usage->acct_limit_list, used_limits);
+		xhash_add(hash, used_limits);
 	}
+	slurm_mutex_unlock(&used_limits_lock);
+
+	return used_limits;
+}
+
+/* Checks for record in usage->user_limit_list of user_id if
+ * usage->user_limit_list doesn't exist it will create it, if the user_id
+ * record doesn't exist it will add it to the list.
+ * In all cases the user record is returned.
+ */
+static slurmdb_used_limits_t *_get_user_used_limits(
+	slurmdb_qos_rec_t *qos_ptr, uint32_t user_id)
+{
+	slurmdb_qos_usage_t *usage = qos_ptr->usage;
+	slurmdb_used_limits_t *used_limits;
+	qos_limit_index_t *index;
+	user_limit_ent_t *ent;
+	char uid_str[11];
+	xhash_t *hash;
+
+	xassert(usage);
+
+	slurm_mutex_lock(&used_limits_lock);
+	index = _get_qos_limit_index(qos_ptr);
+	if (!usage->user_limit_list) {
+		usage->user_limit_list =
+			list_create(slurmdb_destroy_used_limits);
+		/* A new list may reuse the address of a freed one */
+		xhash_free_ptr(&index->user_hash);
+	}
+
+	hash = _user_limit_hash(index, usage->user_limit_list);
+	snprintf(uid_str, sizeof(uid_str), "%u", user_id);
+	if ((ent = xhash_get(hash, uid_str))) {
+		slurm_mutex_unlock(&used_limits_lock);
+		return ent->used_limits;
+	}
+
+	used_limits = xmalloc(sizeof(slurmdb_used_limits_t));
+	used_limits->uid = user_id;
+
+	used_limits->tres = xmalloc(sizeof(uint64_t) * slurmctld_tres_cnt);
+	used_limits->tres_run_mins =
+		xmalloc(sizeof(uint64_t) * slurmctld_tres_cnt);
+
+	list_append(usage->user_limit_list, used_limits);
+	_user_limit_hash_add(hash, used_limits);
+	slurm_mutex_unlock(&used_limits_lock);
 
 	return used_limits;
 }
@@ -466,6 +689,254 @@ static bool _valid_job_assoc(struct job_record *job_ptr)
 	return true;
 }
 
+/* Return the first GrpTRES limit already reached by running jobs, or -1 */
+static int _grp_tres_reached(uint64_t *grp_tres_ctld, uint64_t *grp_used_tres)
+{
+	int i;
+
+	if (!grp_tres_ctld || !grp_used_tres)
+		return -1;
+
+	for (i = 0; i < slurmctld_tres_cnt; i++) {
+		if (i == TRES_ARRAY_ENERGY)
+			continue;
+		if ((grp_tres_ctld[i] != INFINITE64) &&
+		    (grp_used_tres[i] >= grp_tres_ctld[i]))
+			return i;
+	}
+
+	return -1;
+}
+
+/*
+ * Limits reached by running jobs which hold every other job regardless of
+ * its request, keyed by QOS or association id. Only QOS and associations
+ * at such a limit have an entry. They are kept here rather than in the
+ * public usage structures. Entries are set under the assoc_mgr ASSOC and
+ * QOS write locks and read under their read locks.
+ */
+typedef struct {
+	char id_str[11];
+	uint32_t state_reason;	/* limit reached */
+	int tres_pos;		/* TRES position of a GrpTRES limit */
+} limit_blocked_t;
+
+static xhash_t *qos_limit_blocked = NULL;
+static xhash_t *assoc_limit_blocked = NULL;
+
+static const char *_limit_blocked_id(void *item)
+{
+	return ((limit_blocked_t *)item)->id_str;
+}
+
+static void _limit_blocked_free(void *item)
+{
+	xfree(item);
+}
+
+static void _set_limit_blocked(xhash_t **table, uint32_t id,
+			       uint32_t state_reason, int tres_pos)
+{
+	limit_blocked_t *blocked;
+	char id_str[11];
+
+	snprintf(id_str, sizeof(id_str), "%u", id);
+	if (state_reason == WAIT_NO_REASON) {
+		if (*table)
+			xhash_delete(*table, id_str);
+		return;
+	}
+
+	if (!*table)
+		*table = xhash_init(_limit_blocked_id, _limit_blocked_free,
+				    NULL, 0);
+	if (!(blocked = xhash_get(*table, id_str))) {
+		blocked = xmalloc(sizeof(limit_blocked_t));
+		memcpy(blocked->id_str, id_str, sizeof(id_str));
+		xhash_add(*table, blocked);
+	}
+	blocked->state_reason = state_reason;
+	blocked->tres_pos = tres_pos;
+}
+
+static limit_blocked_t *_get_limit_blocked(xhash_t *table, uint32_t id)
+{
+	char id_str[11];
+
+	if (!table || !xhash_count(table))
+		return NULL;
+	snprintf(id_str, sizeof(id_str), "%u", id);
+	return xhash_get(table, id_str);
+}
+
+/*
+ * Note whether running jobs have brought the QOS up to a limit which holds
+ * every other job regardless of its request. Done whenever the usage
+ * changes so acct_policy_job_runnable_pre_select() can hold those jobs
+ * without walking all of the limits (or selecting nodes) for each of them.
+ */
+static void _set_qos_limit_blocked(slurmdb_qos_rec_t *qos_ptr)
+{
+	slurmdb_qos_usage_t *usage;
+	uint32_t state_reason = WAIT_NO_REASON;
+	int tres_pos = -1;
+
+	if (!qos_ptr || !(usage = qos_ptr->usage))
+		return;
+
+	if ((qos_ptr->grp_jobs != INFINITE) &&
+	    (usage->grp_used_jobs >= qos_ptr->grp_jobs)) {
+		state_reason = WAIT_QOS_GRP_JOB;
+	} else if ((tres_pos = _grp_tres_reached(qos_ptr->grp_tres_ctld,
+						 usage->grp_used_tres)) >= 0) {
+		state_reason =
+			_get_tres_state_reason(tres_pos, WAIT_QOS_GRP_UNK);
+	}
+	_set_limit_blocked(&qos_limit_blocked, qos_ptr->id, state_reason,
+			   tres_pos);
+}
+
+static void _set_assoc_limit_blocked(slurmdb_assoc_rec_t *assoc_ptr)
+{
+	slurmdb_assoc_usage_t *usage = assoc_ptr->usage;
+	uint32_t state_reason = WAIT_NO_REASON;
+	int tres_pos = -1;
+
+	if ((assoc_ptr->grp_jobs != INFINITE) &&
+	    (usage->used_jobs >= assoc_ptr->grp_jobs)) {
+		state_reason = WAIT_ASSOC_GRP_JOB;
+	} else if ((tres_pos = _grp_tres_reached(assoc_ptr->grp_tres_ctld,
+						 usage->grp_used_tres)) >= 0) {
+		state_reason =
+			_get_tres_state_reason(tres_pos, WAIT_ASSOC_GRP_UNK);
+	} else if ((assoc_ptr->max_jobs != INFINITE) &&
+		   (usage->used_jobs >= assoc_ptr->max_jobs)) {
+		state_reason = WAIT_ASSOC_MAX_JOBS;
+	}
+	_set_limit_blocked(&assoc_limit_blocked, assoc_ptr->id, state_reason,
+			   tres_pos);
+}
+
+/* Return true if a GrpTRES limit marked as reached still holds this job */
+static bool _grp_tres_blocks_job(struct job_record *job_ptr, int tres_pos,
+				 uint64_t *grp_tres_ctld,
+				 uint64_t *grp_used_tres)
+{
+	if (!grp_tres_ctld || (grp_tres_ctld[tres_pos] == INFINITE64) ||
+	    (grp_used_tres[tres_pos] < grp_tres_ctld[tres_pos]))
+		return false;
+
+	if (job_ptr->limit_set.tres &&
+	    (job_ptr->limit_set.tres[tres_pos] == ADMIN_SET_LIMIT))
+		return false;
+
+	/* A job not asking for any of this TRES is not held by it */
+	if (!job_ptr->tres_req_cnt || !job_ptr->tres_req_cnt[tres_pos])
+		return false;
+
+	return true;
+}
+
+static bool _qos_grp_tres_set(slurmdb_qos_rec_t *qos_ptr, int tres_pos)
+{
+	return (qos_ptr && qos_ptr->grp_tres_ctld &&
+		(qos_ptr->grp_tres_ctld[tres_pos] != INFINITE64));
+}
+
+static bool _qos_grp_jobs_set(slurmdb_qos_rec_t *qos_ptr)
+{
+	return (qos_ptr && (qos_ptr->grp_jobs != INFINITE));
+}
+
+/*
+ * Check the limit_blocked entries of the job's QOS and associations.
+ * A marker only applies if no QOS earlier in the order overrides that
+ * limit and the usage is still at the limit, as the limits may have been
+ * raised since the marker was set.
+ * RET state_reason the job is held for or WAIT_NO_REASON
+ */
+static uint32_t _limit_blocked(struct job_record *job_ptr,
+			       slurmdb_qos_rec_t *qos_ptr_1,
+			       slurmdb_qos_rec_t *qos_ptr_2)
+{
+	slurmdb_qos_rec_t *qos_ptr, *qos_over = NULL;
+	slurmdb_assoc_rec_t *assoc_ptr;
+	limit_blocked_t *blocked;
+	int tres_pos, i;
+
+	for (i = 0; i < 2; i++) {
+		qos_ptr = i ? qos_ptr_2 : qos_ptr_1;
+		if (!qos_ptr || !qos_ptr->usage)
+			continue;
+		if (!(blocked = _get_limit_blocked(qos_limit_blocked,
+						   qos_ptr->id))) {
+			qos_over = qos_ptr;
+			continue;
+		}
+		tres_pos = blocked->tres_pos;
+		switch (blocked->state_reason) {
+		case WAIT_QOS_GRP_JOB:
+			if (!_qos_grp_jobs_set(qos_over) &&
+			    (qos_ptr->grp_jobs != INFINITE) &&
+			    (qos_ptr->usage->grp_used_jobs >=
+			     qos_ptr->grp_jobs))
+				return WAIT_QOS_GRP_JOB;
+			break;
+		default:
+			if (!_qos_grp_tres_set(qos_over, tres_pos) &&
+			    _grp_tres_blocks_job(job_ptr, tres_pos,
+						 qos_ptr->grp_tres_ctld,
+						 qos_ptr->usage->grp_used_tres))
+				return blocked->state_reason;
+			break;
+		}
+		qos_over = qos_ptr;
+	}
+
+	for (assoc_ptr = job_ptr->assoc_ptr; assoc_ptr;
+	     assoc_ptr = assoc_ptr->usage->parent_assoc_ptr) {
+		if (!(blocked = _get_limit_blocked(assoc_limit_blocked,
+						   assoc_ptr->id)))
+			continue;
+		tres_pos = blocked->tres_pos;
+		switch (blocked->state_reason) {
+		case WAIT_ASSOC_GRP_JOB:
+			if (!_qos_grp_jobs_set(qos_ptr_1) &&
+			    !_qos_grp_jobs_set(qos_ptr_2) &&
+			    (assoc_ptr->grp_jobs != INFINITE) &&
+			    (assoc_ptr->usage->used_jobs >=
+			     assoc_ptr->grp_jobs))
+				return WAIT_ASSOC_GRP_JOB;
+			break;
+		case WAIT_ASSOC_MAX_JOBS:
+			/* MaxJobs is only enforced on the job's own assoc */
+			if ((assoc_ptr == job_ptr->assoc_ptr) &&
+			    (!qos_ptr_1 ||
+			     ((qos_ptr_1->max_jobs_pa == INFINITE) &&
+			      (qos_ptr_1->max_jobs_pu == INFINITE))) &&
+			    (!qos_ptr_2 ||
+			     ((qos_ptr_2->max_jobs_pa == INFINITE) &&
+			      (qos_ptr_2->max_jobs_pu == INFINITE))) &&
+			    (assoc_ptr->max_jobs != INFINITE) &&
+			    (assoc_ptr->usage->used_jobs >=
+			     assoc_ptr->max_jobs))
+				return WAIT_ASSOC_MAX_JOBS;
+			break;
+		default:
+			if (!_qos_grp_tres_set(qos_ptr_1, tres_pos) &&
+			    !_qos_grp_tres_set(qos_ptr_2, tres_pos) &&
+			    _grp_tres_blocks_job(job_ptr, tres_pos,
+						 assoc_ptr->grp_tres_ctld,
+						 assoc_ptr->usage->
+						 grp_used_tres))
+				return blocked->state_reason;
+			break;
+		}
+	}
+
+	return WAIT_NO_REASON;
+}
+
 static void _qos_adjust_limit_usage(int type, struct job_record *job_ptr,
 				    slurmdb_qos_rec_t *qos_ptr,
 				    uint64_t *used_tres_run_secs,
@@ -478,10 +949,10 @@ static void _qos_adjust_limit_usage(int type, struct job_record *job_ptr,
 	if (!qos_ptr || !assoc_ptr)
 		return;
 
-	used_limits_a =	_get_acct_used_limits(&qos_ptr->usage->acct_limit_list,
+	used_limits_a =	_get_acct_used_limits(qos_ptr,
 					      assoc_ptr->acct);
 
-	used_limits = _get_user_used_limits(&qos_ptr->usage->user_limit_list,
+	used_limits = _get_user_used_limits(qos_ptr,
 					    job_ptr->user_id);
 
 	switch(type) {
@@ -733,7 +1204,18 @@ static void _adjust_limit_usage(int type, struct job_record *job_ptr)
 		/* now handle all the group limits of the parents */
 		assoc_ptr = assoc_ptr->usage->parent_assoc_ptr;
 	}
+	if ((type == ACCT_POLICY_JOB_BEGIN) || (type == ACCT_POLICY_JOB_FINI)) {
+		_set_qos_limit_blocked(qos_ptr_1);
+		_set_qos_limit_blocked(qos_ptr_2);
+		for (assoc_ptr = job_ptr->assoc_ptr; assoc_ptr;
+		     assoc_ptr = assoc_ptr->usage->parent_assoc_ptr)
+			_set_assoc_limit_blocked(assoc_ptr);
+	}
 	assoc_mgr_unlock(&locks);
+
+	/* Jobs held by a job count limit may be able to run now */
+	if ((type == ACCT_POLICY_JOB_FINI) || (type == ACCT_POLICY_REM_SUBMIT))
+		acct_policy_clear_cache();
 }
 
 static void _set_time_limit(uint32_t *time_limit, uint32_t part_max_time,
@@ -1525,7 +2007,7 @@ static int _qos_policy_validate(job_desc_msg_t *job_desc,
 	    (qos_ptr->max_submit_jobs_pa != INFINITE)) {
 		slurmdb_used_limits_t *used_limits =
 			_get_acct_used_limits(
-				&qos_ptr->usage->acct_limit_list,
+				qos_ptr,
 				assoc_ptr->acct);
 
 		qos_out_ptr->max_submit_jobs_pa = qos_ptr->max_submit_jobs_pa;
@@ -1547,7 +2029,7 @@ static int _qos_policy_validate(job_desc_msg_t *job_desc,
 	    (qos_ptr->max_submit_jobs_pu != INFINITE)) {
 		slurmdb_used_limits_t *used_limits =
 			_get_user_used_limits(
-				&qos_ptr->usage->user_limit_list,
+				qos_ptr,
 				job_desc->user_id);
 
 		qos_out_ptr->max_submit_jobs_pu = qos_ptr->max_submit_jobs_pu;
@@ -1617,10 +2099,10 @@ static int _qos_job_runnable_pre_select(struct job_record *job_ptr,
 
 	wall_mins = qos_ptr->usage->grp_used_wall / 60;
 
-	used_limits_a =	_get_acct_used_limits(&qos_ptr->usage->acct_limit_list,
+	used_limits_a =	_get_acct_used_limits(qos_ptr,
 					      assoc_ptr->acct);
 
-	used_limits = _get_user_used_limits(&qos_ptr->usage->user_limit_list,
+	used_limits = _get_user_used_limits(qos_ptr,
 					    job_ptr->user_id);
 
 
@@ -1823,10 +2305,10 @@ static int _qos_job_runnable_post_select(struct job_record *job_ptr,
 			(uint64_t)(qos_ptr->usage->usage_tres_raw[i] / 60.0);
 	}
 
-	used_limits_a =	_get_acct_used_limits(&qos_ptr->usage->acct_limit_list,
+	used_limits_a =	_get_acct_used_limits(qos_ptr,
 					      assoc_ptr->acct);
 
-	used_limits = _get_user_used_limits(&qos_ptr->usage->user_limit_list,
+	used_limits = _get_user_used_limits(qos_ptr,
 					    job_ptr->user_id);
 
 	tres_usage = _validate_tres_usage_limits_for_qos(
@@ -2336,6 +2818,19 @@ end_it:
 	return rc;
 }
 
+/*
+ * acct_policy_clear_cache - Forget any remembered limit holds. Called when
+ *	usage drops, when limits change and at the start of each scheduling
+ *	cycle.
+ */
+extern void acct_policy_clear_cache(void)
+{
+	slurm_mutex_lock(&pre_select_memo_lock);
+	if (++pre_select_memo_gen == 0)
+		pre_select_memo_gen = 1;
+	slurm_mutex_unlock(&pre_select_memo_lock);
+}
+
 /*
  * acct_policy_add_job_submit - Note that a job has been submitted for
  *	accounting policy purposes.
@@ -2821,6 +3316,7 @@ extern bool acct_policy_job_runnable_pre_select(struct job_record *job_ptr)
 	bool rc = true;
 	uint32_t wall_mins;
 	bool safe_limits = false;
+	uint32_t held_reason;
 	int parent = 0; /* flag to tell us if we are looking at the
 			 * parent or not
 			 */
@@ -2855,6 +3351,19 @@ extern bool acct_policy_job_runnable_pre_select(struct job_record *job_ptr)
 
 	_set_qos_order(job_ptr, &qos_ptr_1, &qos_ptr_2);
 
+	held_reason = _limit_blocked(job_ptr, qos_ptr_1, qos_ptr_2);
+	if (held_reason == WAIT_NO_REASON)
+		held_reason = _pre_select_memo_get(job_ptr->assoc_id,
+						   qos_ptr_1, qos_ptr_2);
+	if (held_reason != WAIT_NO_REASON) {
+		xfree(job_ptr->state_desc);
+		job_ptr->state_reason = held_reason;
+		debug2("job %u being held, %s limit still reached",
+		       job_ptr->job_id, job_reason_string(held_reason));
+		rc = false;
+		goto end_it;
+	}
+
 	/* check the first QOS setting it's values in the qos_rec */
 	if (qos_ptr_1 &&
 	    !(rc = _qos_job_runnable_pre_select(job_ptr, qos_ptr_1, &qos_rec)))
@@ -3017,6 +3526,9 @@ extern bool acct_policy_job_runnable_pre_select(struct job_record *job_ptr)
 		parent = 1;
 	}
 end_it:
+	if (!rc && (held_reason == WAIT_NO_REASON))
+		_pre_select_memo_set(job_ptr->assoc_id, qos_ptr_1, qos_ptr_2,
+				     job_ptr->state_reason);
 	assoc_mgr_unlock(&locks);
 	slurmdb_free_qos_rec_members(&qos_rec);
 
@@ -83,6 +83,13 @@ extern bool acct_policy_validate(job_desc_msg_t *job_desc,
 				 acct_policy_limit_set_t *acct_policy_limit_set,
 				 bool update_call);
 
+/*
+ * acct_policy_clear_cache - Forget any remembered limit holds. Called when
+ *	usage drops, when limits change and at the start of each scheduling
+ *	cycle.
+ */
+extern void acct_policy_clear_cache(void);
+
 /*
  * acct_policy_job_runnable_pre_select - Determine of the specified
  *	job can execute right now or not depending upon accounting
@@ -144,6 +144,7 @@ typedef struct agent_info {
 	slurm_msg_type_t msg_type;	/* RPC to be issued */
 	void **msg_args_pptr;		/* RPC data to be used */
 	uint16_t protocol_version;	/* if set, use this version */
+	msg_envelope_t *envelope;	/* RPC packed once for all nodes */
 } agent_info_t;
 
 typedef struct task_info {
@@ -157,6 +158,7 @@ typedef struct task_info {
 	slurm_msg_type_t msg_type;	/* RPC to be issued */
 	void *msg_args_ptr;		/* ptr to RPC data to be used */
 	uint16_t protocol_version;	/* if set, use this version */
+	msg_envelope_t *envelope;	/* RPC packed once for all nodes */
 } task_info_t;
 
 typedef struct queued_request {
@@ -187,6 +189,7 @@ static int  _setup_requeue(agent_arg_t *agent_arg_ptr, thd_t *thread_ptr,
 static void _sig_handler(int dummy);
 static void _spawn_retry_agent(agent_arg_t * agent_arg_ptr);
 static void *_thread_per_group_rpc(void *args);
+static void _update_ping_loads(List ret_list);
 static int   _valid_agent_arg(agent_arg_t *agent_arg_ptr);
 static void *_wdog(void *args);
 
@@ -345,6 +348,7 @@ void *agent(void *args)
 	_purge_agent_args(agent_arg_ptr);
 
 	if (agent_info_ptr) {
+		slurm_msg_envelope_destroy(agent_info_ptr->envelope);
 		xfree(agent_info_ptr->thread_struct);
 		xfree(agent_info_ptr);
 	}
@@ -483,6 +487,15 @@ static agent_info_t *_make_agent_info(agent_arg_t *agent_arg_ptr)
 	}
 	xfree(span);
 	agent_info_ptr->thread_count = thr_count;
+
+	/*
+	 * Every node gets the same RPC, so pack it and its credential once
+	 * and let each branch of the fan-out send those same bytes. Nodes
+	 * forward them unchanged and each verifies the one credential.
+	 */
+	if (agent_info_ptr->get_reply && (agent_arg_ptr->node_count > 1))
+		agent_info_ptr->envelope = slurm_msg_envelope_create();
+
 	return agent_info_ptr;
 }
 
@@ -499,6 +512,7 @@ static task_info_t *_make_task_data(agent_info_t *agent_info_ptr, int inx)
 	task_info_ptr->msg_type          = agent_info_ptr->msg_type;
 	task_info_ptr->msg_args_ptr      = *agent_info_ptr->msg_args_pptr;
 	task_info_ptr->protocol_version  = agent_info_ptr->protocol_version;
+	task_info_ptr->envelope          = agent_info_ptr->envelope;
 
 	return task_info_ptr;
 }
@@ -790,6 +804,39 @@ static inline int _comm_err(char *node_name, slurm_msg_type_t msg_type)
 	return rc;
 }
 
+/*
+ * Record the CPU load and free memory from every ping reply of a subtree
+ * under one node write lock rather than locking for each node
+ */
+static void _update_ping_loads(List ret_list)
+{
+	ListIterator itr;
+	ret_data_info_t *ret_data_info;
+	ping_slurmd_resp_msg_t *ping_resp;
+	/* Locks: Write node */
+	slurmctld_lock_t node_write_lock =
+		{ NO_LOCK, NO_LOCK, WRITE_LOCK, NO_LOCK, NO_LOCK };
+	bool locked = false;
+
+	itr = list_iterator_create(ret_list);
+	while ((ret_data_info = list_next(itr))) {
+		if ((ret_data_info->type != RESPONSE_PING_SLURMD) ||
+		    !ret_data_info->data)
+			continue;
+		if (!locked) {
+			lock_slurmctld(node_write_lock);
+			locked = true;
+		}
+		ping_resp = (ping_slurmd_resp_msg_t *) ret_data_info->data;
+		reset_node_load(ret_data_info->node_name, ping_resp->cpu_load);
+		reset_node_free_mem(ret_data_info->node_name,
+				    ping_resp->free_mem);
+	}
+	list_iterator_destroy(itr);
+	if (locked)
+		unlock_slurmctld(node_write_lock);
+}
+
 /* return a value for which WEXITSTATUS() returns 1 */
 static int _wif_status(void)
 {
@@ -878,6 +925,7 @@ static void *_thread_per_group_rpc(void *args)
 
 	msg.msg_type = msg_type;
 	msg.data     = task_ptr->msg_args_ptr;
+	msg.envelope = task_ptr->envelope;
 #if 0
  	info("sending message type %u to %s", msg_type, thread_ptr->nodelist);
 #endif
@@ -931,22 +979,14 @@ static void *_thread_per_group_rpc(void *args)
 	}
 
 	//info("got %d messages back", list_count(ret_list));
+	/* SPECIAL CASE: Record nodes' CPU load and free memory */
+	if (msg_type == REQUEST_PING)
+		_update_ping_loads(ret_list);
+
 	itr = list_iterator_create(ret_list);
 	while ((ret_data_info = list_next(itr)) != NULL) {
 		rc = slurm_get_return_code(ret_data_info->type,
 					   ret_data_info->data);
-		/* SPECIAL CASE: Record node's CPU load */
-		if (ret_data_info->type == RESPONSE_PING_SLURMD) {
-			ping_slurmd_resp_msg_t *ping_resp;
-			ping_resp = (ping_slurmd_resp_msg_t *)
-				    ret_data_info->data;
-			lock_slurmctld(node_write_lock);
-			reset_node_load(ret_data_info->node_name,
-					ping_resp->cpu_load);
-			reset_node_free_mem(ret_data_info->node_name,
-					    ping_resp->free_mem);
-			unlock_slurmctld(node_write_lock);
-		}
 		/* SPECIAL CASE: Mark node as IDLE if job already complete */
 		if (is_kill_msg &&
 		    (rc == ESLURMD_KILL_JOB_ALREADY_COMPLETE)) {
@@ -700,6 +700,7 @@ int main(int argc, char **argv)
 	slurm_crypto_fini();	/* must be after ctx_destroy */
 	slurm_conf_destroy();
 	slurm_api_clear_config();
+	fini_buf_cache();
 	usleep(500000);
 }
 #else
@@ -1321,6 +1322,8 @@ static void _update_assoc(slurmdb_assoc_rec_t *rec)
 	    || !(accounting_enforce & ACCOUNTING_ENFORCE_LIMITS))
 		return;
 
+	acct_policy_clear_cache();
+
 	lock_slurmctld(job_write_lock);
 	job_iterator = list_iterator_create(job_list);
 	while ((job_ptr = list_next(job_iterator))) {
@@ -1373,6 +1376,8 @@ static void _update_qos(slurmdb_qos_rec_t *rec)
 	    || !(accounting_enforce & ACCOUNTING_ENFORCE_LIMITS))
 		return;
 
+	acct_policy_clear_cache();
+
 	lock_slurmctld(job_write_lock);
 	job_iterator = list_iterator_create(job_list);
 	while ((job_ptr = list_next(job_iterator))) {
@@ -134,6 +134,38 @@ typedef struct {
 	uid_t     uid;
 } _foreach_pack_job_info_t;
 
+/*
+ * Packed RESPONSE_JOB_INFO record of one job, reused by later job info
+ * requests for as long as no job, partition, configuration or QOS change
+ * has been made since it was built. The scheduler updates a few fields
+ * without touching last_job_update and the expected start and end times
+ * depend upon the current time, so those are rewritten in place each time
+ * the record is copied out. The scheduler also replaces the state_desc and
+ * sched_nodes strings in many places without touching last_job_update, so
+ * the values packed are kept and the record is rebuilt when either changes.
+ */
+typedef struct job_pack_cache {
+	char *data;
+	uint32_t size;
+	time_t build_time;
+	uint32_t qos_version;
+	uint16_t protocol_version;
+	uint16_t show_flags;
+	/* Offsets of the fields rewritten on copy */
+	uint32_t job_state_off;
+	uint32_t state_reason_off;
+	uint32_t start_time_off;
+	uint32_t end_time_off;
+	uint32_t last_sched_eval_off;
+	uint32_t priority_off;
+	/* Values packed of the strings the scheduler changes */
+	char *state_desc;
+	char *sched_nodes;
+	/* Node list of a completing job and the node_bitmap_cg it names */
+	char *nodes_cg;
+	bitstr_t *nodes_cg_bitmap;
+} job_pack_cache_t;
+
 /* Global variables */
 List   job_list = NULL;		/* job_record list */
 time_t last_job_update;		/* time of last update to job records */
@@ -151,6 +183,11 @@ static struct   job_record **job_array_hash_j = NULL;
 static struct   job_record **job_array_hash_t = NULL;
 static bool     kill_invalid_dep;
 static time_t   last_file_write_time = (time_t) 0;
+static uint32_t job_pack_rec_size = 0;	/* avg packed job record size */
+static pthread_mutex_t job_pack_rec_size_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t job_pack_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t job_pack_cache_hits = 0;
+static uint64_t job_pack_cache_misses = 0;
 static uint32_t max_array_size = NO_VAL;
 static bool	purge_quit = false;
 static struct timeval purge_start_time = {0, 0};
@@ -205,7 +242,12 @@ static uint32_t _max_switch_wait(uint32_t input_wait);
 static void _notify_srun_missing_step(struct job_record *job_ptr, int node_inx,
 				      time_t now, time_t node_boot_time);
 static int  _open_job_state_file(char **state_file);
+static void _free_job_pack_cache(struct job_record *job_ptr);
 static void _pack_job_for_ckpt (struct job_record *job_ptr, Buf buffer);
+static void _pack_job_record(struct job_record *dump_job_ptr,
+			     uint16_t show_flags, Buf buffer,
+			     uint16_t protocol_version, uid_t uid,
+			     job_pack_cache_t *pack_cache);
 static void _pack_default_job_details(struct job_record *job_ptr,
 				      Buf buffer,
 				      uint16_t protocol_version);
@@ -4009,6 +4051,7 @@ extern struct job_record *job_array_split(struct job_record *job_ptr)
 	job_ptr_pend->details  = save_details;
 	job_ptr_pend->step_list = save_step_list;
 	job_ptr_pend->db_index = save_db_index;
+	job_ptr_pend->pack_cache = NULL;
 
 	job_ptr_pend->prio_factors = save_prio_factors;
 	slurm_copy_priority_factors_object(job_ptr_pend->prio_factors,
@@ -8493,6 +8536,7 @@ static void _list_delete_job(void *job_entry)
 	}
 
 	delete_job_details(job_ptr);
+	_free_job_pack_cache(job_ptr);
 	xfree(job_ptr->account);
 	xfree(job_ptr->admin_comment);
 	xfree(job_ptr->alias_list);
@@ -8754,6 +8798,46 @@ static int _foreach_pack_jobid(void *object, void *arg)
 	return SLURM_SUCCESS;
 }
 
+/*
+ * Create the buffer for a job info dump, sized from the average packed
+ * record size seen in earlier dumps so large responses are allocated once
+ * rather than grown (and copied) repeatedly as records are appended.
+ * IN rec_cnt - number of job records expected to be packed
+ */
+static Buf _init_job_pack_buf(int rec_cnt)
+{
+	uint64_t size = BUF_SIZE;
+	uint32_t rec_size;
+
+	/* Dumps run concurrently under the job read lock */
+	slurm_mutex_lock(&job_pack_rec_size_lock);
+	rec_size = job_pack_rec_size;
+	slurm_mutex_unlock(&job_pack_rec_size_lock);
+
+	if (rec_size && (rec_cnt > 0)) {
+		/* Allow for some growth over the last average */
+		size += (uint64_t) rec_cnt * (rec_size + (rec_size / 8));
+		size = MIN(size, MAX_BUF_SIZE / 2);
+	}
+
+	return init_buf((uint32_t) size);
+}
+
+/* Record the average packed job record size from a completed dump */
+static void _set_job_pack_rec_size(Buf buffer, uint32_t header_size,
+				   uint32_t jobs_packed)
+{
+	uint32_t rec_size;
+
+	if (!jobs_packed)
+		return;
+
+	rec_size = (get_buf_offset(buffer) - header_size) / jobs_packed;
+	slurm_mutex_lock(&job_pack_rec_size_lock);
+	job_pack_rec_size = rec_size;
+	slurm_mutex_unlock(&job_pack_rec_size_lock);
+}
+
 /*
  * pack_all_jobs - dump all job information for all jobs in
  *	machine independent form (for network transmission)
@@ -8771,19 +8855,24 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 			  uint16_t show_flags, uid_t uid, uint32_t filter_uid,
 			  uint16_t protocol_version)
 {
-	uint32_t jobs_packed = 0, tmp_offset;
+	uint32_t jobs_packed = 0, tmp_offset, header_size;
 	_foreach_pack_job_info_t pack_info = {0};
 	Buf buffer;
 
 	buffer_ptr[0] = NULL;
 	*buffer_size = 0;
 
-	buffer = init_buf(BUF_SIZE);
+	/* Can't estimate how many jobs a single user has */
+	if (filter_uid == NO_VAL)
+		buffer = _init_job_pack_buf(list_count(job_list));
+	else
+		buffer = init_buf(BUF_SIZE);
 
 	/* write message body header : size and time */
 	/* put in a place holder job record count of 0 for now */
 	pack32(jobs_packed, buffer);
 	pack_time(time(NULL), buffer);
+	header_size = get_buf_offset(buffer);
 
 	/* write individual job records */
 	part_filter_set(uid);
@@ -8798,6 +8887,7 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 	list_for_each(job_list, _foreach_pack_job_ptr, &pack_info);
 
 	part_filter_clear();
+	_set_job_pack_rec_size(buffer, header_size, jobs_packed);
 
 	/* put the real record count in the message body header */
 	tmp_offset = get_buf_offset(buffer);
@@ -8827,7 +8917,7 @@ extern void pack_spec_jobs(char **buffer_ptr, int *buffer_size, List job_ids,
 			   uint16_t show_flags, uid_t uid, uint32_t filter_uid,
 			   uint16_t protocol_version)
 {
-	uint32_t jobs_packed = 0, tmp_offset;
+	uint32_t jobs_packed = 0, tmp_offset, header_size;
 	_foreach_pack_job_info_t pack_info = {0};
 	Buf buffer;
 
@@ -8836,12 +8926,13 @@ extern void pack_spec_jobs(char **buffer_ptr, int *buffer_size, List job_ids,
 	buffer_ptr[0] = NULL;
 	*buffer_size = 0;
 
-	buffer = init_buf(BUF_SIZE);
+	buffer = _init_job_pack_buf(list_count(job_ids));
 
 	/* write message body header : size and time */
 	/* put in a place holder job record count of 0 for now */
 	pack32(jobs_packed, buffer);
 	pack_time(time(NULL), buffer);
+	header_size = get_buf_offset(buffer);
 
 	/* write individual job records */
 	part_filter_set(uid);
@@ -8856,6 +8947,7 @@ extern void pack_spec_jobs(char **buffer_ptr, int *buffer_size, List job_ids,
 	list_for_each(job_ids, _foreach_pack_jobid, &pack_info);
 
 	part_filter_clear();
+	_set_job_pack_rec_size(buffer, header_size, jobs_packed);
 
 	/* put the real record count in the message body header */
 	tmp_offset = get_buf_offset(buffer);
@@ -8971,6 +9063,219 @@ static void _pack_job_gres(struct job_record *dump_job_ptr, Buf buffer,
 		      dump_job_ptr->gres_detail_cnt, buffer);
 }
 
+/* Reason reported for a job, see _pack_job_record() */
+static uint16_t _job_pack_state_reason(struct job_record *job_ptr)
+{
+	if ((job_ptr->state_reason == WAIT_NO_REASON) &&
+	    IS_JOB_PENDING(job_ptr)) {
+		/* Scheduling cycle in progress, send latest reason */
+		return job_ptr->state_reason_prev;
+	}
+	return job_ptr->state_reason;
+}
+
+/* Start and end times reported for a job, see _pack_job_record() */
+static void _job_pack_times(struct job_record *job_ptr, time_t begin_time,
+			    uint32_t time_limit, time_t *start_time,
+			    time_t *end_time)
+{
+	*start_time = 0;
+	*end_time = 0;
+	if (IS_JOB_STARTED(job_ptr)) {
+		/* Report actual start time, in past */
+		*start_time = job_ptr->start_time;
+		*end_time = job_ptr->end_time;
+	} else if (job_ptr->start_time != 0) {
+		/* Report expected start time,
+		 * making sure that time is not in the past */
+		*start_time = MAX(job_ptr->start_time, time(NULL));
+		if (time_limit != NO_VAL) {
+			*end_time = MAX(job_ptr->end_time,
+					(*start_time + time_limit * 60));
+		}
+	} else	if (begin_time > time(NULL)) {
+		/* earliest start time in the future */
+		*start_time = begin_time;
+		if (time_limit != NO_VAL) {
+			*end_time = MAX(job_ptr->end_time,
+					(*start_time + time_limit * 60));
+		}
+	}
+}
+
+static void _free_job_pack_cache(struct job_record *job_ptr)
+{
+	job_pack_cache_t *pack_cache = job_ptr->pack_cache;
+
+	if (pack_cache) {
+		xfree(pack_cache->data);
+		xfree(pack_cache->state_desc);
+		xfree(pack_cache->sched_nodes);
+		xfree(pack_cache->nodes_cg);
+		FREE_NULL_BITMAP(pack_cache->nodes_cg_bitmap);
+		xfree(pack_cache);
+		job_ptr->pack_cache = NULL;
+	}
+}
+
+/* Test if the cached name of node_bitmap_cg is still current */
+static bool _nodes_cg_current(struct job_record *job_ptr,
+			      job_pack_cache_t *pack_cache)
+{
+	if (!pack_cache || !pack_cache->nodes_cg)
+		return false;
+	if (!job_ptr->node_bitmap_cg)
+		return !pack_cache->nodes_cg_bitmap;
+	return (pack_cache->nodes_cg_bitmap &&
+		bit_equal(job_ptr->node_bitmap_cg,
+			  pack_cache->nodes_cg_bitmap));
+}
+
+/*
+ * Pack the node list of a completing job. Completing jobs are not cached,
+ * but every job info request reports them, so the name of node_bitmap_cg
+ * is kept with the job's cache record until the bitmap changes. A record
+ * holding only this list has no build_time and is never used as a whole.
+ */
+static void _pack_job_nodes_cg(struct job_record *job_ptr, Buf buffer)
+{
+	job_pack_cache_t *pack_cache;
+	bitstr_t *nodes_cg_bitmap = NULL;
+	char *nodes_cg;
+
+	slurm_mutex_lock(&job_pack_cache_lock);
+	if (_nodes_cg_current(job_ptr, job_ptr->pack_cache)) {
+		packstr(job_ptr->pack_cache->nodes_cg, buffer);
+		slurm_mutex_unlock(&job_pack_cache_lock);
+		return;
+	}
+	slurm_mutex_unlock(&job_pack_cache_lock);
+
+	/* Build the name without blocking other job info requests */
+	nodes_cg = bitmap2node_name(job_ptr->node_bitmap_cg);
+	if (job_ptr->node_bitmap_cg)
+		nodes_cg_bitmap = bit_copy(job_ptr->node_bitmap_cg);
+	packstr(nodes_cg, buffer);
+
+	slurm_mutex_lock(&job_pack_cache_lock);
+	if (!job_ptr->pack_cache)
+		job_ptr->pack_cache = xmalloc(sizeof(job_pack_cache_t));
+	pack_cache = job_ptr->pack_cache;
+	xfree(pack_cache->nodes_cg);
+	FREE_NULL_BITMAP(pack_cache->nodes_cg_bitmap);
+	pack_cache->nodes_cg = nodes_cg;
+	pack_cache->nodes_cg_bitmap = nodes_cg_bitmap;
+	slurm_mutex_unlock(&job_pack_cache_lock);
+}
+
+/*
+ * Only the current format is cached. Completing jobs report a node list
+ * that shrinks as epilogs finish and SHOW_DETAIL2 adds the batch script,
+ * which depends upon the requesting user.
+ */
+static bool _job_pack_cacheable(struct job_record *job_ptr,
+				uint16_t show_flags, uint16_t protocol_version)
+{
+	if (protocol_version != SLURM_PROTOCOL_VERSION)
+		return false;
+	if (show_flags & SHOW_DETAIL2)
+		return false;
+	if (IS_JOB_COMPLETING(job_ptr))
+		return false;
+	return true;
+}
+
+static bool _job_pack_cache_valid(struct job_record *job_ptr,
+				  job_pack_cache_t *pack_cache,
+				  uint16_t show_flags,
+				  uint16_t protocol_version)
+{
+	if (!pack_cache ||
+	    (pack_cache->show_flags != show_flags) ||
+	    (pack_cache->protocol_version != protocol_version))
+		return false;
+	if ((pack_cache->build_time <= last_job_update) ||
+	    (pack_cache->build_time <= last_part_update) ||
+	    (pack_cache->build_time <= slurmctld_conf.last_update))
+		return false;
+	if (pack_cache->qos_version != assoc_mgr_lock_version(QOS_LOCK))
+		return false;
+	if (xstrcmp(pack_cache->state_desc, job_ptr->state_desc) ||
+	    xstrcmp(pack_cache->sched_nodes, job_ptr->sched_nodes))
+		return false;
+	return true;
+}
+
+/* Copy a job's cached record into buffer and refresh its volatile fields.
+ * RET true if the cache was valid and used */
+static bool _unpack_job_pack_cache(struct job_record *job_ptr,
+				   uint16_t show_flags, Buf buffer,
+				   uint16_t protocol_version)
+{
+	job_pack_cache_t *pack_cache;
+	uint32_t base, end, time_limit;
+	time_t begin_time = 0, start_time, end_time;
+	bool valid;
+
+	slurm_mutex_lock(&job_pack_cache_lock);
+	pack_cache = job_ptr->pack_cache;
+	valid = _job_pack_cache_valid(job_ptr, pack_cache, show_flags,
+				      protocol_version);
+	if (valid) {
+		base = get_buf_offset(buffer);
+		packmem_array(pack_cache->data, pack_cache->size, buffer);
+		end = get_buf_offset(buffer);
+
+		if ((job_ptr->time_limit == NO_VAL) && job_ptr->part_ptr)
+			time_limit = job_ptr->part_ptr->max_time;
+		else
+			time_limit = job_ptr->time_limit;
+		if (job_ptr->details)
+			begin_time = job_ptr->details->begin_time;
+		_job_pack_times(job_ptr, begin_time, time_limit,
+				&start_time, &end_time);
+
+		set_buf_offset(buffer, base + pack_cache->job_state_off);
+		pack32(job_ptr->job_state, buffer);
+		set_buf_offset(buffer, base + pack_cache->state_reason_off);
+		pack16(_job_pack_state_reason(job_ptr), buffer);
+		set_buf_offset(buffer, base + pack_cache->start_time_off);
+		pack_time(start_time, buffer);
+		set_buf_offset(buffer, base + pack_cache->end_time_off);
+		pack_time(end_time, buffer);
+		set_buf_offset(buffer, base + pack_cache->last_sched_eval_off);
+		pack_time(job_ptr->last_sched_eval, buffer);
+		set_buf_offset(buffer, base + pack_cache->priority_off);
+		pack32(job_ptr->priority, buffer);
+		set_buf_offset(buffer, end);
+		job_pack_cache_hits++;
+	} else
+		job_pack_cache_misses++;
+	slurm_mutex_unlock(&job_pack_cache_lock);
+
+	return valid;
+}
+
+/*
+ * get_job_pack_cache_stats - report how often pack_job() could copy a job's
+ *	cached record rather than packing it again
+ * OUT hits - cacheable records copied from the cache
+ * OUT misses - cacheable records packed again
+ * IN reset - clear the counters after reading them
+ */
+extern void get_job_pack_cache_stats(uint64_t *hits, uint64_t *misses,
+				     bool reset)
+{
+	slurm_mutex_lock(&job_pack_cache_lock);
+	*hits = job_pack_cache_hits;
+	*misses = job_pack_cache_misses;
+	if (reset) {
+		job_pack_cache_hits = 0;
+		job_pack_cache_misses = 0;
+	}
+	slurm_mutex_unlock(&job_pack_cache_lock);
+}
+
 /*
  * pack_job - dump all configuration information about a specific job in
  *	machine independent form (for network transmission)
@@ -8984,11 +9289,61 @@ static void _pack_job_gres(struct job_record *dump_job_ptr, Buf buffer,
  */
 void pack_job(struct job_record *dump_job_ptr, uint16_t show_flags, Buf buffer,
 	      uint16_t protocol_version, uid_t uid)
+{
+	job_pack_cache_t *pack_cache;
+	uint32_t base;
+
+	if (!_job_pack_cacheable(dump_job_ptr, show_flags, protocol_version)) {
+		_pack_job_record(dump_job_ptr, show_flags, buffer,
+				 protocol_version, uid, NULL);
+		return;
+	}
+
+	if (_unpack_job_pack_cache(dump_job_ptr, show_flags, buffer,
+				   protocol_version))
+		return;
+
+	pack_cache = xmalloc(sizeof(job_pack_cache_t));
+	pack_cache->build_time = time(NULL);
+	pack_cache->qos_version = assoc_mgr_lock_version(QOS_LOCK);
+	pack_cache->protocol_version = protocol_version;
+	pack_cache->show_flags = show_flags;
+	pack_cache->state_desc = xstrdup(dump_job_ptr->state_desc);
+	pack_cache->sched_nodes = xstrdup(dump_job_ptr->sched_nodes);
+
+	base = get_buf_offset(buffer);
+	_pack_job_record(dump_job_ptr, show_flags, buffer, protocol_version,
+			 uid, pack_cache);
+	pack_cache->size = get_buf_offset(buffer) - base;
+	pack_cache->data = xmalloc_nz(pack_cache->size);
+	memcpy(pack_cache->data, get_buf_data(buffer) + base,
+	       pack_cache->size);
+	pack_cache->job_state_off       -= base;
+	pack_cache->state_reason_off    -= base;
+	pack_cache->start_time_off      -= base;
+	pack_cache->end_time_off        -= base;
+	pack_cache->last_sched_eval_off -= base;
+	pack_cache->priority_off        -= base;
+
+	slurm_mutex_lock(&job_pack_cache_lock);
+	_free_job_pack_cache(dump_job_ptr);
+	dump_job_ptr->pack_cache = pack_cache;
+	slurm_mutex_unlock(&job_pack_cache_lock);
+}
+
+/*
+ * _pack_job_record - pack a job for pack_job()
+ * IN pack_cache - if set, record the offsets of the fields which
+ *	_unpack_job_pack_cache() rewrites (current protocol version only)
+ */
+static void _pack_job_record(struct job_record *dump_job_ptr,
+			     uint16_t show_flags, Buf buffer,
+			     uint16_t protocol_version, uid_t uid,
+			     job_pack_cache_t *pack_cache)
 {
 	struct job_details *detail_ptr;
 	time_t begin_time = 0, start_time = 0, end_time = 0;
 	uint32_t time_limit;
-	char *nodelist = NULL;
 	assoc_mgr_lock_t locks = { NO_LOCK, NO_LOCK, READ_LOCK, NO_LOCK,
 				   NO_LOCK, NO_LOCK, NO_LOCK };
 
@@ -9012,14 +9367,13 @@ void pack_job(struct job_record *dump_job_ptr, uint16_t show_flags, Buf buffer,
 		pack32(dump_job_ptr->group_id, buffer);
 		pack32(dump_job_ptr->profile,  buffer);
 
+		if (pack_cache)
+			pack_cache->job_state_off = get_buf_offset(buffer);
 		pack32(dump_job_ptr->job_state,    buffer);
 		pack16(dump_job_ptr->batch_flag,   buffer);
-		if ((dump_job_ptr->state_reason == WAIT_NO_REASON) &&
-		    IS_JOB_PENDING(dump_job_ptr)) {
-			/* Scheduling cycle in progress, send latest reason */
-			pack16(dump_job_ptr->state_reason_prev, buffer);
-		} else
-			pack16(dump_job_ptr->state_reason, buffer);
+		if (pack_cache)
+			pack_cache->state_reason_off = get_buf_offset(buffer);
+		pack16(_job_pack_state_reason(dump_job_ptr), buffer);
 		pack8(dump_job_ptr->power_flags,   buffer);
 		pack8(dump_job_ptr->reboot,        buffer);
 		pack16(dump_job_ptr->restart_cnt,  buffer);
@@ -9048,34 +9402,26 @@ void pack_job(struct job_record *dump_job_ptr, uint16_t show_flags, Buf buffer,
 
 		pack_time(begin_time, buffer);
 
-		if (IS_JOB_STARTED(dump_job_ptr)) {
-			/* Report actual start time, in past */
-			start_time = dump_job_ptr->start_time;
-			end_time = dump_job_ptr->end_time;
-		} else if (dump_job_ptr->start_time != 0) {
-			/* Report expected start time,
-			 * making sure that time is not in the past */
-			start_time = MAX(dump_job_ptr->start_time, time(NULL));
-			if (time_limit != NO_VAL) {
-				end_time = MAX(dump_job_ptr->end_time,
-					       (start_time + time_limit * 60));
-			}
-		} else	if (begin_time > time(NULL)) {
-			/* earliest start time in the future */
-			start_time = begin_time;
-			if (time_limit != NO_VAL) {
-				end_time = MAX(dump_job_ptr->end_time,
-					       (start_time + time_limit * 60));
-			}
-		}
+		_job_pack_times(dump_job_ptr, begin_time, time_limit,
+				&start_time, &end_time);
+		if (pack_cache)
+			pack_cache->start_time_off = get_buf_offset(buffer);
 		pack_time(start_time, buffer);
+		if (pack_cache)
+			pack_cache->end_time_off = get_buf_offset(buffer);
 		pack_time(end_time, buffer);
 
 		pack_time(dump_job_ptr->suspend_time, buffer);
 		pack_time(dump_job_ptr->pre_sus_time, buffer);
 		pack_time(dump_job_ptr->resize_time, buffer);
+		if (pack_cache) {
+			pack_cache->last_sched_eval_off =
+				get_buf_offset(buffer);
+		}
 		pack_time(dump_job_ptr->last_sched_eval, buffer);
 		pack_time(dump_job_ptr->preempt_time, buffer);
+		if (pack_cache)
+			pack_cache->priority_off = get_buf_offset(buffer);
 		pack32(dump_job_ptr->priority, buffer);
 		packdouble(dump_job_ptr->billable_tres, buffer);
 
@@ -9084,12 +9430,8 @@ void pack_job(struct job_record *dump_job_ptr, uint16_t show_flags, Buf buffer,
 		 * the number of cpus and nodes that are currently allocated. */
 		if (!IS_JOB_COMPLETING(dump_job_ptr))
 			packstr(dump_job_ptr->nodes, buffer);
-		else {
-			nodelist =
-				bitmap2node_name(dump_job_ptr->node_bitmap_cg);
-			packstr(nodelist, buffer);
-			xfree(nodelist);
-		}
+		else
+			_pack_job_nodes_cg(dump_job_ptr, buffer);
 
 		packstr(dump_job_ptr->sched_nodes, buffer);
 
@@ -9279,12 +9621,8 @@ void pack_job(struct job_record *dump_job_ptr, uint16_t show_flags, Buf buffer,
 		 * the number of cpus and nodes that are currently allocated. */
 		if (!IS_JOB_COMPLETING(dump_job_ptr))
 			packstr(dump_job_ptr->nodes, buffer);
-		else {
-			nodelist =
-				bitmap2node_name(dump_job_ptr->node_bitmap_cg);
-			packstr(nodelist, buffer);
-			xfree(nodelist);
-		}
+		else
+			_pack_job_nodes_cg(dump_job_ptr, buffer);
 
 		packstr(dump_job_ptr->sched_nodes, buffer);
 
@@ -9454,12 +9792,8 @@ void pack_job(struct job_record *dump_job_ptr, uint16_t show_flags, Buf buffer,
 		 * the number of cpus and nodes that are currently allocated. */
 		if (!IS_JOB_COMPLETING(dump_job_ptr))
 			packstr(dump_job_ptr->nodes, buffer);
-		else {
-			nodelist =
-				bitmap2node_name(dump_job_ptr->node_bitmap_cg);
-			packstr(nodelist, buffer);
-			xfree(nodelist);
-		}
+		else
+			_pack_job_nodes_cg(dump_job_ptr, buffer);
 
 		packstr(dump_job_ptr->sched_nodes, buffer);
 
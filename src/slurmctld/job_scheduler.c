@@ -1464,6 +1464,7 @@ static int _schedule(uint32_t job_limit)
 	}
 #endif
 
+	acct_policy_clear_cache();
 	part_cnt = list_count(part_list);
 	failed_parts = xmalloc(sizeof(struct part_record *) * part_cnt);
 	failed_resv = xmalloc(sizeof(struct slurmctld_resv*) * MAX_FAILED_RESV);
@@ -76,8 +76,30 @@ static slurm_submit_ops_t *ops = NULL;
 static plugin_context_t **g_context = NULL;
 static char *submit_plugin_list = NULL;
 static pthread_mutex_t g_context_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_context_cond = PTHREAD_COND_INITIALIZER;
+static int g_context_users = 0;	/* plugin calls running without the lock */
 static bool init_run = false;
 
+/*
+ * Plugin calls are made without holding g_context_lock so that jobs submitted
+ * under the job read lock may be evaluated in parallel. Each plugin serializes
+ * its own state as needed. g_context_users keeps the plugins loaded meanwhile.
+ */
+static void _context_use(void)
+{
+	slurm_mutex_lock(&g_context_lock);
+	g_context_users++;
+	slurm_mutex_unlock(&g_context_lock);
+}
+
+static void _context_done(void)
+{
+	slurm_mutex_lock(&g_context_lock);
+	if (--g_context_users == 0)
+		slurm_cond_broadcast(&g_context_cond);
+	slurm_mutex_unlock(&g_context_lock);
+}
+
 /*
  * Initialize the job submit plugin.
  *
@@ -147,6 +169,8 @@ extern int job_submit_plugin_fini(void)
 	int i, j, rc = SLURM_SUCCESS;
 
 	slurm_mutex_lock(&g_context_lock);
+	while (g_context_users)
+		slurm_cond_wait(&g_context_cond, &g_context_lock);
 	if (g_context_cnt < 0)
 		goto fini;
 
@@ -220,14 +244,14 @@ extern int job_submit_plugin_submit(struct job_descriptor *job_desc,
 
 	START_TIMER;
 	rc = job_submit_plugin_init();
-	slurm_mutex_lock(&g_context_lock);
+	_context_use();
 	/* NOTE: On function entry read locks are set on config, job, node and
 	 * partition structures. Do not attempt to unlock them and then
 	 * lock again (say with a write lock) since doing so will trigger
-	 * a deadlock with the g_context_lock above. */
+	 * a deadlock with job_submit_plugin_fini() waiting for this call. */
 	for (i = 0; ((i < g_context_cnt) && (rc == SLURM_SUCCESS)); i++)
 		rc = (*(ops[i].submit))(job_desc, submit_uid, err_msg);
-	slurm_mutex_unlock(&g_context_lock);
+	_context_done();
 	END_TIMER2("job_submit_plugin_submit");
 
 	return rc;
@@ -247,10 +271,10 @@ extern int job_submit_plugin_modify(struct job_descriptor *job_desc,
 
 	START_TIMER;
 	rc = job_submit_plugin_init();
-	slurm_mutex_lock(&g_context_lock);
+	_context_use();
 	for (i = 0; ((i < g_context_cnt) && (rc == SLURM_SUCCESS)); i++)
 		rc = (*(ops[i].modify))(job_desc, job_ptr, submit_uid);
-	slurm_mutex_unlock(&g_context_lock);
+	_context_done();
 	END_TIMER2("job_submit_plugin_modify");
 
 	return rc;
@@ -67,6 +67,7 @@
 #include "src/common/slurm_acct_gather_energy.h"
 #include "src/common/slurm_ext_sensors.h"
 #include "src/common/slurm_mcs.h"
+#include "src/common/slurm_route.h"
 #include "src/common/xassert.h"
 #include "src/common/xstring.h"
 #include "src/slurmctld/agent.h"
@@ -785,8 +786,16 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 			   uint16_t show_flags, uid_t uid,
 			   uint16_t protocol_version)
 {
+	/* Average packed node record size from the last dump, every node
+	 * gets a record so this sizes the buffer well on the next call.
+	 * Dumps run concurrently under the node read lock. */
+	static uint32_t node_pack_rec_size = 0;
+	static pthread_mutex_t node_pack_rec_size_lock =
+		PTHREAD_MUTEX_INITIALIZER;
 	int inx;
-	uint32_t nodes_packed, tmp_offset, node_scaling;
+	uint32_t nodes_packed, tmp_offset, node_scaling, header_size;
+	uint32_t rec_size;
+	uint64_t init_size = BUF_SIZE * 16;
 	Buf buffer;
 	time_t now = time(NULL);
 	struct node_record *node_ptr = node_record_table_ptr;
@@ -798,7 +807,15 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 	buffer_ptr[0] = NULL;
 	*buffer_size = 0;
 
-	buffer = init_buf (BUF_SIZE*16);
+	slurm_mutex_lock(&node_pack_rec_size_lock);
+	rec_size = node_pack_rec_size;
+	slurm_mutex_unlock(&node_pack_rec_size_lock);
+	if (rec_size) {
+		init_size = (uint64_t) node_record_count *
+			    (rec_size + (rec_size / 8));
+		init_size = MIN(init_size + BUF_SIZE, MAX_BUF_SIZE / 2);
+	}
+	buffer = init_buf((uint32_t) init_size);
 	nodes_packed = 0;
 
 	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
@@ -809,6 +826,7 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 		pack32(node_scaling, buffer);
 
 		pack_time(now, buffer);
+		header_size = get_buf_offset(buffer);
 
 		/* write node records */
 		part_filter_set(uid);
@@ -846,6 +864,13 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 			nodes_packed++;
 		}
 		part_filter_clear();
+		if (nodes_packed) {
+			rec_size = (get_buf_offset(buffer) - header_size) /
+				   nodes_packed;
+			slurm_mutex_lock(&node_pack_rec_size_lock);
+			node_pack_rec_size = rec_size;
+			slurm_mutex_unlock(&node_pack_rec_size_lock);
+		}
 	} else {
 		error("select_g_select_jobinfo_pack: protocol_version "
 		      "%hu not supported", protocol_version);
@@ -2474,6 +2499,7 @@ extern int validate_node_specs(slurm_node_registration_status_msg_t *reg_msg,
 
 	if (IS_NODE_NO_RESPOND(node_ptr) || IS_NODE_POWER_UP(node_ptr)) {
 		info("Node %s now responding", node_ptr->name);
+		route_set_node_slow(node_ptr->name, false);
 		node_ptr->node_state &= (~NODE_STATE_NO_RESPOND);
 		node_ptr->node_state &= (~NODE_STATE_POWER_UP);
 		node_ptr->node_state &= (~NODE_STATE_REBOOT);
@@ -3119,6 +3145,8 @@ static void _node_did_resp(struct node_record *node_ptr)
 		}
 	}
 	node_ptr->last_response = MAX(now, node_ptr->last_response);
+	/* NO_RESPOND may have been cleared elsewhere, so always do this */
+	route_set_node_slow(node_ptr->name, false);
 	if (IS_NODE_NO_RESPOND(node_ptr) || IS_NODE_POWER_UP(node_ptr)) {
 		info("Node %s now responding", node_ptr->name);
 		node_ptr->node_state &= (~NODE_STATE_NO_RESPOND);
@@ -3255,6 +3283,7 @@ void node_not_resp (char *name, time_t msg_time, slurm_msg_type_t resp_type)
 
 	if (!IS_NODE_POWER_SAVE(node_ptr)) {
 		node_ptr->node_state |= NODE_STATE_NO_RESPOND;
+		route_set_node_slow(node_ptr->name, true);
 #ifdef HAVE_FRONT_END
 		last_front_end_update = time(NULL);
 #else
@@ -111,9 +111,35 @@ static uint64_t *rpc_user_time = NULL;
 static pthread_mutex_t throttle_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t throttle_cond = PTHREAD_COND_INITIALIZER;
 
+/* Counts of the RPCs slurmd can aggregate, see get_msg_aggr_stats() */
+static pthread_mutex_t aggr_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t aggr_composite_cnt = 0;
+static uint32_t aggr_msg_cnt = 0;
+static uint32_t aggr_direct_cnt = 0;
+
+/*
+ * Node registrations waiting to be validated. The first RPC thread to find
+ * no batch in progress takes the job and node write locks once and
+ * validates every queued registration, the others wait for their result.
+ */
+typedef struct reg_batch_rec {
+	slurm_msg_t *msg;
+	int error_code;
+	bool newly_up;
+	bool done;
+	struct reg_batch_rec *next;
+} reg_batch_rec_t;
+
+static pthread_mutex_t reg_batch_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t reg_batch_cond = PTHREAD_COND_INITIALIZER;
+static reg_batch_rec_t *reg_batch_head = NULL;
+static reg_batch_rec_t **reg_batch_tail = &reg_batch_head;
+static bool reg_batch_active = false;
+
 static void         _fill_ctld_conf(slurm_ctl_conf_t * build_ptr);
 static void         _kill_job_on_msg_fail(uint32_t job_id);
 static int          _is_prolog_finished(uint32_t job_id);
+static bool         _msg_aggr_eligible(uint16_t msg_type);
 static int          _make_step_cred(struct step_record *step_rec,
 				    slurm_cred_t **slurm_cred,
 				    uint16_t protocol_version);
@@ -136,7 +162,8 @@ inline static void  _slurm_rpc_complete_job_allocation(slurm_msg_t * msg);
 inline static void  _slurm_rpc_complete_batch_script(slurm_msg_t * msg,
 						     bool *run_scheduler,
 						     bool running_composite);
-inline static void  _slurm_rpc_complete_prolog(slurm_msg_t * msg);
+inline static void  _slurm_rpc_complete_prolog(slurm_msg_t * msg,
+					       bool running_composite);
 inline static void  _slurm_rpc_dump_conf(slurm_msg_t * msg);
 inline static void  _slurm_rpc_dump_front_end(slurm_msg_t * msg);
 inline static void  _slurm_rpc_dump_jobs(slurm_msg_t * msg);
@@ -294,6 +321,12 @@ void slurmctld_req(slurm_msg_t *msg, connection_arg_t *arg)
 		}
 	}
 
+	if (_msg_aggr_eligible(msg->msg_type)) {
+		slurm_mutex_lock(&aggr_stats_mutex);
+		aggr_direct_cnt++;
+		slurm_mutex_unlock(&aggr_stats_mutex);
+	}
+
 	switch (msg->msg_type) {
 	case REQUEST_RESOURCE_ALLOCATION:
 		_slurm_rpc_allocate_resources(msg, false);
@@ -345,7 +378,7 @@ void slurmctld_req(slurm_msg_t *msg, connection_arg_t *arg)
 		_slurm_rpc_complete_job_allocation(msg);
 		break;
 	case REQUEST_COMPLETE_PROLOG:
-		_slurm_rpc_complete_prolog(msg);
+		_slurm_rpc_complete_prolog(msg, 0);
 		break;
 	case REQUEST_COMPLETE_BATCH_JOB:
 	case REQUEST_COMPLETE_BATCH_SCRIPT:
@@ -1943,9 +1976,49 @@ static void _slurm_rpc_complete_job_allocation(slurm_msg_t * msg)
 	trace_job(job_ptr, __func__, "return");
 }
 
+/*
+ * Message types slurmd sends through MESSAGE_COMPOSITE when
+ * MsgAggregationParams is set, see _slurm_rpc_comp_msg_list()
+ */
+static bool _msg_aggr_eligible(uint16_t msg_type)
+{
+	switch (msg_type) {
+	case REQUEST_COMPLETE_BATCH_SCRIPT:
+	case REQUEST_COMPLETE_BATCH_JOB:
+	case REQUEST_COMPLETE_PROLOG:
+	case REQUEST_STEP_COMPLETE:
+	case MESSAGE_EPILOG_COMPLETE:
+	case MESSAGE_NODE_REGISTRATION_STATUS:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * get_msg_aggr_stats - report how many RPCs which slurmd can aggregate
+ *	arrived inside of composite messages and how many arrived directly
+ * OUT composite_cnt - MESSAGE_COMPOSITE RPCs received
+ * OUT aggr_cnt - messages carried by them
+ * OUT direct_cnt - messages of the same types sent on their own
+ * IN reset - clear the counters after reading them
+ */
+extern void get_msg_aggr_stats(uint32_t *composite_cnt, uint32_t *aggr_cnt,
+			       uint32_t *direct_cnt, bool reset)
+{
+	slurm_mutex_lock(&aggr_stats_mutex);
+	*composite_cnt = aggr_composite_cnt;
+	*aggr_cnt = aggr_msg_cnt;
+	*direct_cnt = aggr_direct_cnt;
+	if (reset)
+		aggr_composite_cnt = aggr_msg_cnt = aggr_direct_cnt = 0;
+	slurm_mutex_unlock(&aggr_stats_mutex);
+}
+
 /* _slurm_rpc_complete_prolog - process RPC to note the
  *	completion of a prolog */
-static void _slurm_rpc_complete_prolog(slurm_msg_t * msg)
+static void _slurm_rpc_complete_prolog(slurm_msg_t * msg,
+				       bool running_composite)
 {
 	int error_code = SLURM_SUCCESS;
 	DEF_TIMERS;
@@ -1960,9 +2033,11 @@ static void _slurm_rpc_complete_prolog(slurm_msg_t * msg)
 	debug2("Processing RPC: REQUEST_COMPLETE_PROLOG from JobId=%u",
 	       comp_msg->job_id);
 
-	lock_slurmctld(job_write_lock);
+	if (!running_composite)
+		lock_slurmctld(job_write_lock);
 	error_code = prolog_complete(comp_msg->job_id, comp_msg->prolog_rc);
-	unlock_slurmctld(job_write_lock);
+	if (!running_composite)
+		unlock_slurmctld(job_write_lock);
 
 	END_TIMER2("_slurm_rpc_complete_prolog");
 
@@ -1970,12 +2045,13 @@ static void _slurm_rpc_complete_prolog(slurm_msg_t * msg)
 	if (error_code) {
 		info("_slurm_rpc_complete_prolog JobId=%u: %s ",
 		     comp_msg->job_id, slurm_strerror(error_code));
-		slurm_send_rc_msg(msg, error_code);
 	} else {
 		debug2("_slurm_rpc_complete_prolog JobId=%u %s",
 		       comp_msg->job_id, TIME_STR);
-		slurm_send_rc_msg(msg, SLURM_SUCCESS);
 	}
+	/* Aggregated senders do not wait for a reply */
+	if (!running_composite)
+		slurm_send_rc_msg(msg, error_code);
 }
 
 /* _slurm_rpc_complete_batch - process RPC from slurmstepd to note the
@@ -2561,6 +2637,81 @@ static void _slurm_rpc_event_log(slurm_msg_t * msg)
 	slurm_send_rc_msg(msg, error_code);
 }
 
+/* Validate one node registration, caller holds the job and node write locks */
+static int _validate_registration(slurm_msg_t *msg, bool *newly_up)
+{
+	slurm_node_registration_status_msg_t *node_reg_stat_msg =
+		(slurm_node_registration_status_msg_t *) msg->data;
+
+#ifdef HAVE_FRONT_END		/* Operates only on front-end */
+	return validate_nodes_via_front_end(node_reg_stat_msg,
+					    msg->protocol_version, newly_up);
+#else
+	validate_jobs_on_node(node_reg_stat_msg);
+	return validate_node_specs(node_reg_stat_msg, msg->protocol_version,
+				   newly_up);
+#endif
+}
+
+/*
+ * Queue a node registration and wait until it has been validated. When no
+ * batch is in progress, this thread validates everything queued so far
+ * under a single acquisition of the slurmctld locks. A registration storm
+ * thus costs one lock cycle per batch rather than one per node.
+ */
+static int _validate_registration_batch(slurm_msg_t *msg, bool *newly_up)
+{
+	/* Locks: Read config, write job, write node */
+	slurmctld_lock_t job_write_lock = {
+		READ_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK, NO_LOCK };
+	reg_batch_rec_t rec, *batch, *next;
+	int batch_cnt;
+
+	memset(&rec, 0, sizeof(reg_batch_rec_t));
+	rec.msg = msg;
+
+	slurm_mutex_lock(&reg_batch_mutex);
+	*reg_batch_tail = &rec;
+	reg_batch_tail = &rec.next;
+	while (!rec.done) {
+		if (reg_batch_active) {
+			slurm_cond_wait(&reg_batch_cond, &reg_batch_mutex);
+			continue;
+		}
+
+		/* Take everything queued so far as our batch */
+		reg_batch_active = true;
+		batch = reg_batch_head;
+		reg_batch_head = NULL;
+		reg_batch_tail = &reg_batch_head;
+		slurm_mutex_unlock(&reg_batch_mutex);
+
+		batch_cnt = 0;
+		lock_slurmctld(job_write_lock);
+		for (next = batch; next; next = next->next) {
+			next->error_code = _validate_registration(
+				next->msg, &next->newly_up);
+			batch_cnt++;
+		}
+		unlock_slurmctld(job_write_lock);
+		if (batch_cnt > 1)
+			debug2("%s: validated %d node registrations",
+			       __func__, batch_cnt);
+
+		slurm_mutex_lock(&reg_batch_mutex);
+		for (; batch; batch = next) {
+			next = batch->next;	/* batch may be freed once done */
+			batch->done = true;
+		}
+		reg_batch_active = false;
+		slurm_cond_broadcast(&reg_batch_cond);
+	}
+	slurm_mutex_unlock(&reg_batch_mutex);
+
+	*newly_up = rec.newly_up;
+	return rec.error_code;
+}
+
 /* _slurm_rpc_node_registration - process RPC to determine if a node's
  *	actual configuration satisfies the configured specification */
 static void _slurm_rpc_node_registration(slurm_msg_t * msg,
@@ -2569,12 +2720,9 @@ static void _slurm_rpc_node_registration(slurm_msg_t * msg,
 	/* init */
 	DEF_TIMERS;
 	int error_code = SLURM_SUCCESS;
-	bool newly_up = false;
+	bool newly_up = false, conf_match;
 	slurm_node_registration_status_msg_t *node_reg_stat_msg =
 		(slurm_node_registration_status_msg_t *) msg->data;
-	/* Locks: Read config, write job, write node */
-	slurmctld_lock_t job_write_lock = {
-		READ_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK, NO_LOCK };
 	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred,
 					 slurmctld_config.auth_info);
 
@@ -2604,20 +2752,17 @@ static void _slurm_rpc_node_registration(slurm_msg_t * msg,
 			      "set DebugFlags=NO_CONF_HASH in your slurm.conf.",
 			      node_reg_stat_msg->node_name);
 		}
-		if (!running_composite)
-			lock_slurmctld(job_write_lock);
-#ifdef HAVE_FRONT_END		/* Operates only on front-end */
-		error_code = validate_nodes_via_front_end(node_reg_stat_msg,
-							  msg->protocol_version,
-							  &newly_up);
-#else
-		validate_jobs_on_node(node_reg_stat_msg);
-		error_code = validate_node_specs(node_reg_stat_msg,
-						 msg->protocol_version,
-						 &newly_up);
-#endif
-		if (!running_composite)
-			unlock_slurmctld(job_write_lock);
+		/* Only a node with our node table may get index forwards */
+		conf_match = ((node_reg_stat_msg->hash_val != NO_VAL) &&
+			      (node_reg_stat_msg->hash_val ==
+			       slurm_get_hash_val()));
+		forward_set_node_table_ok(node_reg_stat_msg->node_name,
+					  conf_match);
+		if (running_composite)
+			error_code = _validate_registration(msg, &newly_up);
+		else
+			error_code = _validate_registration_batch(msg,
+								  &newly_up);
 		END_TIMER2("_slurm_rpc_node_registration");
 		if (newly_up) {
 			queue_job_scheduler();
@@ -5543,6 +5688,10 @@ static void  _slurm_rpc_composite_msg(slurm_msg_t *msg)
 		config_update = slurmctld_conf.last_update;
 	}
 
+	slurm_mutex_lock(&aggr_stats_mutex);
+	aggr_composite_cnt++;
+	slurm_mutex_unlock(&aggr_stats_mutex);
+
 	_throttle_start(&active_rpc_cnt);
 	lock_slurmctld(job_write_lock);
 	gettimeofday(&start_tv, NULL);
@@ -5618,6 +5767,11 @@ static void  _slurm_rpc_comp_msg_list(composite_msg_t * comp_msg,
 		*/
 		FREE_NULL_LIST(next_msg->ret_list);
 		next_msg->ret_list = msg_list_in;
+		if (_msg_aggr_eligible(next_msg->msg_type)) {
+			slurm_mutex_lock(&aggr_stats_mutex);
+			aggr_msg_cnt++;
+			slurm_mutex_unlock(&aggr_stats_mutex);
+		}
 		switch (next_msg->msg_type) {
 		case MESSAGE_COMPOSITE:
 			comp_resp_msg = xmalloc(sizeof(composite_msg_t));
@@ -5663,6 +5817,9 @@ static void  _slurm_rpc_comp_msg_list(composite_msg_t * comp_msg,
 			_slurm_rpc_complete_batch_script(next_msg,
 							 run_scheduler, 1);
 			break;
+		case REQUEST_COMPLETE_PROLOG:
+			_slurm_rpc_complete_prolog(next_msg, 1);
+			break;
 		case REQUEST_STEP_COMPLETE:
 			_slurm_rpc_step_complete(next_msg, 1);
 			break;
@@ -54,6 +54,17 @@ typedef struct connection_arg {
 /* Free memory used to track RPC usage by type and user */
 extern void free_rpc_stats(void);
 
+/*
+ * get_msg_aggr_stats - report how many RPCs which slurmd can aggregate
+ *	arrived inside of composite messages and how many arrived directly
+ * OUT composite_cnt - MESSAGE_COMPOSITE RPCs received
+ * OUT aggr_cnt - messages carried by them
+ * OUT direct_cnt - messages of the same types sent on their own
+ * IN reset - clear the counters after reading them
+ */
+extern void get_msg_aggr_stats(uint32_t *composite_cnt, uint32_t *aggr_cnt,
+			       uint32_t *direct_cnt, bool reset);
+
 /*
  * slurmctld_req  - Process an individual RPC request
  * IN/OUT msg - the request message, data associated with the message is freed
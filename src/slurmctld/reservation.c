@@ -102,6 +102,32 @@ uint32_t  cnodes_per_mp = 0;
 uint32_t  cpus_per_mp = 0;
 #endif
 
+/*
+ * Time index of reservations used by job_test_resv(). Entries are sorted by
+ * start time and carry the largest end time of any entry at or before them,
+ * so the reservations overlapping a time window are found with a binary
+ * search plus a short backward scan rather than a walk of resv_list. Floating
+ * reservations move with the current time and are kept out of the sorted
+ * index. The index is rebuilt when last_resv_update changes or when an
+ * indexed reservation ends (it may need to be advanced).
+ */
+typedef struct resv_index_ent {
+	slurmctld_resv_t *resv_ptr;
+	time_t start_time;	/* Earliest of start_time and start_time_first */
+	time_t max_end_time;	/* Latest end_time of this and prior entries */
+	int list_inx;		/* Position in resv_list */
+} resv_index_ent_t;
+
+static resv_index_ent_t *resv_index = NULL;
+static int resv_index_cnt = 0;
+static resv_index_ent_t *resv_float = NULL;
+static int resv_float_cnt = 0;
+static int resv_index_size = 0;
+static resv_index_ent_t *resv_query = NULL;	/* _resv_index_query() output */
+static time_t resv_index_update = (time_t) 0;	/* last_resv_update at build */
+static time_t resv_index_expire = (time_t) 0;	/* rebuild at this time */
+static bool resv_index_valid = false;
+
 /*
  * the two following structs enable to build a
  * planning of a constraint evolution over time
@@ -169,6 +195,9 @@ static int  _post_resv_delete(slurmctld_resv_t *resv_ptr);
 static int  _post_resv_update(slurmctld_resv_t *resv_ptr,
 			      slurmctld_resv_t *old_resv_ptr);
 static int  _resize_resv(slurmctld_resv_t *resv_ptr, uint32_t node_cnt);
+static void _resv_index_build(time_t now);
+static void _resv_index_fini(void);
+static int  _resv_index_query(time_t start_time, time_t end_time, time_t now);
 static void _restore_resv(slurmctld_resv_t *dest_resv,
 			  slurmctld_resv_t *src_resv);
 static bool _resv_overlap(time_t start_time, time_t end_time,
@@ -2451,6 +2480,7 @@ extern int create_resv(resv_desc_msg_t *resv_desc_ptr)
 extern void resv_fini(void)
 {
 	FREE_NULL_LIST(resv_list);
+	_resv_index_fini();
 }
 
 /* Update an exiting resource reservation */
@@ -4863,6 +4893,130 @@ extern uint32_t job_test_watts_resv(struct job_record *job_ptr, time_t when,
 	return resv_cnt;
 }
 
+static int _resv_index_sort_start(const void *x, const void *y)
+{
+	const resv_index_ent_t *ent1 = x, *ent2 = y;
+
+	if (ent1->start_time < ent2->start_time)
+		return -1;
+	if (ent1->start_time > ent2->start_time)
+		return 1;
+	return (ent1->list_inx - ent2->list_inx);
+}
+
+static int _resv_index_sort_list(const void *x, const void *y)
+{
+	const resv_index_ent_t *ent1 = x, *ent2 = y;
+
+	return (ent1->list_inx - ent2->list_inx);
+}
+
+/* Rebuild the reservation time index from resv_list */
+static void _resv_index_build(time_t now)
+{
+	ListIterator iter;
+	slurmctld_resv_t *resv_ptr;
+	resv_index_ent_t *ent;
+	time_t max_end_time = (time_t) 0;
+	int i, list_inx = 0, resv_cnt;
+
+	resv_cnt = list_count(resv_list);
+	if (resv_cnt > resv_index_size) {
+		resv_index_size = resv_cnt;
+		xrealloc(resv_index, sizeof(resv_index_ent_t) * resv_cnt);
+		xrealloc(resv_float, sizeof(resv_index_ent_t) * resv_cnt);
+		xrealloc(resv_query, sizeof(resv_index_ent_t) * resv_cnt);
+	}
+	resv_index_cnt = 0;
+	resv_float_cnt = 0;
+	resv_index_expire = (time_t) 0;
+
+	iter = list_iterator_create(resv_list);
+	while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
+		if (resv_ptr->flags & RESERVE_FLAG_TIME_FLOAT) {
+			ent = &resv_float[resv_float_cnt++];
+		} else {
+			if (resv_ptr->end_time <= now)
+				_advance_resv_time(resv_ptr);
+			if ((resv_ptr->end_time > now) &&
+			    ((resv_index_expire == 0) ||
+			     (resv_index_expire > resv_ptr->end_time)))
+				resv_index_expire = resv_ptr->end_time;
+			ent = &resv_index[resv_index_cnt++];
+			ent->start_time = MIN(resv_ptr->start_time,
+					      resv_ptr->start_time_first);
+		}
+		ent->resv_ptr = resv_ptr;
+		ent->list_inx = list_inx++;
+	}
+	list_iterator_destroy(iter);
+
+	qsort(resv_index, resv_index_cnt, sizeof(resv_index_ent_t),
+	      _resv_index_sort_start);
+	for (i = 0; i < resv_index_cnt; i++) {
+		max_end_time = MAX(max_end_time,
+				   resv_index[i].resv_ptr->end_time);
+		resv_index[i].max_end_time = max_end_time;
+	}
+
+	/* last_resv_update has one second resolution, so an index built in
+	 * the same second as a change could miss a later change */
+	resv_index_update = last_resv_update;
+	resv_index_valid = (now > last_resv_update);
+}
+
+static void _resv_index_fini(void)
+{
+	xfree(resv_index);
+	xfree(resv_float);
+	xfree(resv_query);
+	resv_index_cnt = 0;
+	resv_float_cnt = 0;
+	resv_index_size = 0;
+	resv_index_valid = false;
+}
+
+/*
+ * Identify reservations which may overlap the time window from start_time to
+ * end_time. Floating reservations are always included, so the caller must
+ * still test each reservation's times.
+ * RET count of records placed in resv_query, in resv_list order
+ */
+static int _resv_index_query(time_t start_time, time_t end_time, time_t now)
+{
+	int i, lo, hi, mid, cnt = 0;
+
+	if (!resv_index_valid || (resv_index_update != last_resv_update) ||
+	    ((resv_index_cnt + resv_float_cnt) != list_count(resv_list)) ||
+	    (resv_index_expire && (now >= resv_index_expire)))
+		_resv_index_build(now);
+
+	/* Find the first entry starting at or after end_time */
+	lo = 0;
+	hi = resv_index_cnt;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (resv_index[mid].start_time < end_time)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	for (i = lo - 1; i >= 0; i--) {
+		if (resv_index[i].max_end_time <= start_time)
+			break;	/* No earlier entry ends after start_time */
+		if (resv_index[i].resv_ptr->end_time > start_time)
+			resv_query[cnt++] = resv_index[i];
+	}
+	for (i = 0; i < resv_float_cnt; i++)
+		resv_query[cnt++] = resv_float[i];
+	if (cnt > 1) {
+		qsort(resv_query, cnt, sizeof(resv_index_ent_t),
+		      _resv_index_sort_list);
+	}
+
+	return cnt;
+}
+
 /*
  * Determine which nodes a job can use based upon reservations
  * IN job_ptr      - job to test
@@ -4893,8 +5047,7 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 	time_t job_start_time, job_end_time, lic_resv_time;
 	time_t start_relative, end_relative;
 	time_t now = time(NULL);
-	ListIterator iter;
-	int i, rc = SLURM_SUCCESS, rc2;
+	int i, j, resv_cnt, rc = SLURM_SUCCESS, rc2;
 
 	*resv_overlap = false;	/* initialize to false */
 	job_start_time = *when;
@@ -4954,8 +5107,9 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 
 		/* if there are any overlapping reservations, we need to
 		 * prevent the job from using those nodes (e.g. MAINT nodes) */
-		iter = list_iterator_create(resv_list);
-		while ((res2_ptr = (slurmctld_resv_t *) list_next(iter))) {
+		resv_cnt = _resv_index_query(job_start_time, job_end_time, now);
+		for (j = 0; j < resv_cnt; j++) {
+			res2_ptr = resv_query[j].resv_ptr;
 			if ((resv_ptr->flags & RESERVE_FLAG_MAINT) ||
 			    ((resv_ptr->flags & RESERVE_FLAG_OVERLAP) &&
 			     !(res2_ptr->flags & RESERVE_FLAG_MAINT)) ||
@@ -4970,7 +5124,6 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 				bit_and_not(*node_bitmap,res2_ptr->node_bitmap);
 			}
 		}
-		list_iterator_destroy(iter);
 
 		if (slurmctld_conf.debug_flags & DEBUG_FLAG_RESERVATION) {
 			char *nodes = bitmap2node_name(*node_bitmap);
@@ -5017,8 +5170,9 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 	for (i = 0; ; i++) {
 		lic_resv_time = (time_t) 0;
 
-		iter = list_iterator_create(resv_list);
-		while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
+		resv_cnt = _resv_index_query(job_start_time, job_end_time, now);
+		for (j = 0; j < resv_cnt; j++) {
+			resv_ptr = resv_query[j].resv_ptr;
 			if (resv_ptr->flags & RESERVE_FLAG_TIME_FLOAT) {
 				start_relative = resv_ptr->start_time + now;
 				if (resv_ptr->duration == INFINITE)
@@ -5094,7 +5248,6 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 				}
 			}
 		}
-		list_iterator_destroy(iter);
 
 		if ((rc == SLURM_SUCCESS) && move_time) {
 			if (license_job_test(job_ptr, job_start_time)
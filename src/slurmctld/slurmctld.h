@@ -699,6 +699,9 @@ struct job_record {
 	char *origin_cluster;		/* cluster name that the job was
 					 * submitted from */
 	uint16_t other_port;		/* port for client communications */
+	struct job_pack_cache *pack_cache; /* cached RESPONSE_JOB_INFO
+					 * record, see pack_job()
+					 * (Internal use only, don't save) */
 	char *partition;		/* name of job partition(s) */
 	List part_ptr_list;		/* list of pointers to partition recs */
 	bool part_nodes_missing;	/* set if job's nodes removed from this
@@ -1860,6 +1863,16 @@ extern void pack_all_part(char **buffer_ptr, int *buffer_size,
 			  uint16_t show_flags, uid_t uid,
 			  uint16_t protocol_version);
 
+/*
+ * get_job_pack_cache_stats - report how often pack_job() could copy a job's
+ *	cached record rather than packing it again
+ * OUT hits - cacheable records copied from the cache
+ * OUT misses - cacheable records packed again
+ * IN reset - clear the counters after reading them
+ */
+extern void get_job_pack_cache_stats(uint64_t *hits, uint64_t *misses,
+				     bool reset);
+
 /*
  * pack_job - dump all configuration information about a specific job in
  *	machine independent form (for network transmission)
@@ -39,7 +39,9 @@
 #include <stdio.h>
 
 #include "src/slurmctld/agent.h"
+#include "src/slurmctld/proc_req.h"
 #include "src/slurmctld/slurmctld.h"
+#include "src/common/assoc_mgr.h"
 #include "src/common/list.h"
 #include "src/common/pack.h"
 #include "src/common/xstring.h"
@@ -122,6 +124,10 @@ extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
  * level IN - clear backfilled_jobs count if set */
 extern void reset_stats(int level)
 {
+	uint64_t zmsg_cnt, zbytes_in, zbytes_out;
+	uint64_t pack_hits, pack_misses;
+	uint32_t composite_cnt, aggr_cnt, direct_cnt;
+
 	slurmctld_diag_stats.proc_req_raw = 0;
 	slurmctld_diag_stats.proc_req_threads = 0;
 	slurmctld_diag_stats.schedule_cycle_max = 0;
@@ -151,5 +157,29 @@ extern void reset_stats(int level)
 	slurmctld_diag_stats.bf_last_depth_try = 0;
 	slurmctld_diag_stats.bf_active = 0;
 
+	/* Record assoc_mgr lock contention for the interval just ended */
+	assoc_mgr_log_lock_stats(true);
+
+	slurm_get_msg_compress_stats(&zmsg_cnt, &zbytes_in, &zbytes_out, true);
+	if (zmsg_cnt) {
+		info("RPC reply compression: %"PRIu64" replies, "
+		     "%"PRIu64" bytes sent for %"PRIu64" (%"PRIu64" saved)",
+		     zmsg_cnt, zbytes_out, zbytes_in, zbytes_in - zbytes_out);
+	}
+
+	get_msg_aggr_stats(&composite_cnt, &aggr_cnt, &direct_cnt, true);
+	if (composite_cnt || direct_cnt) {
+		info("Message aggregation: %u composite RPCs carrying %u "
+		     "messages, %u messages sent directly",
+		     composite_cnt, aggr_cnt, direct_cnt);
+	}
+
+	get_job_pack_cache_stats(&pack_hits, &pack_misses, true);
+	if (pack_hits || pack_misses) {
+		info("Job pack cache: %"PRIu64" records copied, "
+		     "%"PRIu64" packed again",
+		     pack_hits, pack_misses);
+	}
+
 	last_proc_req_start = time(NULL);
 }
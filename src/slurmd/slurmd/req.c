@@ -1853,6 +1853,7 @@ static void _note_batch_job_finished(uint32_t job_id)
 
 /* Send notification to slurmctld we are finished running the prolog.
  * This is needed on system that don't use srun to launch their tasks.
+ * If enabled, use message aggregation.
  */
 static void _notify_slurmctld_prolog_fini(
 	uint32_t job_id, uint32_t prolog_return_code)
@@ -1861,6 +1862,22 @@ static void _notify_slurmctld_prolog_fini(
 	slurm_msg_t req_msg;
 	complete_prolog_msg_t req;
 
+	if (conf->msg_aggr_window_msgs > 1) {
+		/* message aggregation is enabled */
+		slurm_msg_t *msg = xmalloc(sizeof(slurm_msg_t));
+		complete_prolog_msg_t *comp_msg =
+			xmalloc(sizeof(complete_prolog_msg_t));
+
+		slurm_msg_t_init(msg);
+		comp_msg->job_id    = job_id;
+		comp_msg->prolog_rc = prolog_return_code;
+		msg->msg_type = REQUEST_COMPLETE_PROLOG;
+		msg->data     = comp_msg;
+
+		msg_aggr_add_msg(msg, 0, NULL);
+		return;
+	}
+
 	slurm_msg_t_init(&req_msg);
 	req.job_id	= job_id;
 	req.prolog_rc	= prolog_return_code;
@@ -5,6 +5,7 @@
 
 #include <src/common/pack.h>
 #include <src/common/xmalloc.h>
+#include <src/common/xstring.h>
 
 #include <testsuite/dejagnu.h>
 
@@ -17,6 +18,126 @@
 		pass( _msg );       \
 } while (0)
 
+typedef struct {
+	uint32_t job_id;
+	uint32_t step_id;
+	uint16_t flags;
+	uint8_t  state;
+	uint64_t mem;
+	time_t   start_time;
+	char    *name;
+	uint32_t exit_code;
+	char    *node_list;
+	char    *comment;
+} field_rec_t;
+
+static const pack_field_t rec_fields[] = {
+	PACK_FIELD(32, field_rec_t, job_id),
+	PACK_FIELD(32, field_rec_t, step_id),
+	PACK_FIELD(16, field_rec_t, flags),
+	PACK_FIELD(8, field_rec_t, state),
+	PACK_FIELD(64, field_rec_t, mem),
+	PACK_FIELD(TIME, field_rec_t, start_time),
+	PACK_FIELD(STR, field_rec_t, name),
+	PACK_FIELD(32, field_rec_t, exit_code),
+	PACK_FIELD(STR, field_rec_t, node_list),
+	PACK_FIELD(STR, field_rec_t, comment),
+};
+
+static void _pack_rec_manual(field_rec_t *rec, Buf buffer)
+{
+	pack32(rec->job_id, buffer);
+	pack32(rec->step_id, buffer);
+	pack16(rec->flags, buffer);
+	pack8(rec->state, buffer);
+	pack64(rec->mem, buffer);
+	pack_time(rec->start_time, buffer);
+	packstr(rec->name, buffer);
+	pack32(rec->exit_code, buffer);
+	packstr(rec->node_list, buffer);
+	packstr(rec->comment, buffer);
+}
+
+static void _free_rec_strs(field_rec_t *rec)
+{
+	xfree(rec->name);
+	xfree(rec->node_list);
+	xfree(rec->comment);
+}
+
+static int _rec_differ(field_rec_t *rec1, field_rec_t *rec2)
+{
+	return ((rec1->job_id != rec2->job_id) ||
+		(rec1->step_id != rec2->step_id) ||
+		(rec1->flags != rec2->flags) ||
+		(rec1->state != rec2->state) ||
+		(rec1->mem != rec2->mem) ||
+		(rec1->start_time != rec2->start_time) ||
+		(rec1->exit_code != rec2->exit_code) ||
+		xstrcmp(rec1->name, rec2->name) ||
+		xstrcmp(rec1->node_list, rec2->node_list) ||
+		xstrcmp(rec1->comment, rec2->comment));
+}
+
+/* Check the table driven packer against hand written pack calls */
+static void _test_pack_fields(void)
+{
+	field_rec_t rec = {
+		.job_id = 123456, .step_id = 7, .flags = 0x8001,
+		.state = 3, .mem = 0x123456789abcULL, .start_time = 1500000000,
+		.name = "test_job", .exit_code = 0xffffffff,
+		.node_list = "node[0001-4096]", .comment = NULL
+	}, rec2 = {
+		.job_id = 1, .name = "", .node_list = NULL,
+		.comment = "second record"
+	}, out, out2;
+	Buf b1, b2;
+	uint32_t len, full;
+	int rc, bad = 0;
+
+	b1 = init_buf(0);
+	b2 = init_buf(0);
+	_pack_rec_manual(&rec, b1);
+	_pack_rec_manual(&rec2, b1);
+	pack_fields(rec_fields, PACK_FIELD_CNT(rec_fields), &rec, b2);
+	TEST(pack_fields_size(rec_fields, PACK_FIELD_CNT(rec_fields),
+			      &rec) != get_buf_offset(b2),
+	     "pack_fields_size");
+	pack_fields(rec_fields, PACK_FIELD_CNT(rec_fields), &rec2, b2);
+	TEST((get_buf_offset(b1) != get_buf_offset(b2)) ||
+	     memcmp(get_buf_data(b1), get_buf_data(b2), get_buf_offset(b1)),
+	     "pack_fields matches manual packing");
+
+	/* Two records back to back, with NULL and empty strings */
+	memset(&out, 0, sizeof(out));
+	memset(&out2, 0, sizeof(out2));
+	full = get_buf_offset(b1);
+	set_buf_offset(b1, 0);
+	rc = unpack_fields(rec_fields, PACK_FIELD_CNT(rec_fields), &out, b1);
+	rc |= unpack_fields(rec_fields, PACK_FIELD_CNT(rec_fields), &out2, b1);
+	TEST(rc || _rec_differ(&rec, &out) || _rec_differ(&rec2, &out2) ||
+	     out.comment || !out2.name || out2.name[0] || out2.node_list ||
+	     (get_buf_offset(b1) != full),
+	     "unpack_fields round trip");
+	_free_rec_strs(&out);
+	_free_rec_strs(&out2);
+
+	/* Every truncation of a record must fail rather than read past it */
+	len = pack_fields_size(rec_fields, PACK_FIELD_CNT(rec_fields), &rec);
+	for (b2->size = 0; b2->size < len; b2->size++) {
+		memset(&out, 0, sizeof(out));
+		set_buf_offset(b2, 0);
+		if (unpack_fields(rec_fields, PACK_FIELD_CNT(rec_fields),
+				  &out, b2) == 0)
+			bad++;
+		_free_rec_strs(&out);
+	}
+	TEST(bad, "unpack_fields of truncated buffer");
+
+	free_buf(b1);
+	free_buf(b2);
+}
+
 int main (int argc, char *argv[])
 {
 	Buf buffer;
@@ -83,6 +204,9 @@ int main (int argc, char *argv[])
 	xfree(outstring);
 
 	free_buf(buffer);
+
+	_test_pack_fields();
+
 	totals();
 	return failed;
 